@@ -14,10 +14,782 @@
 #endif
 #endif
 
+// The reference counting policy used by shr<T> for any type T which does not
+//   explicitly select one (see shr_counting<T> below).  Define
+//   SMARTPOINTER_ATOMIC_COUNT to make lock-free atomic counting the default
+//   or SMARTPOINTER_BIASED_COUNT to make biased counting the default.
+//   Biased counts cannot be embedded in an object, so ishr_counted uses
+//   atomic counting instead in that case.
+
+#if   defined(SMARTPOINTER_BIASED_COUNT)
+#define SMARTPOINTER_COUNT_POLICY shr_biased_count
+#define SMARTPOINTER_ISHR_POLICY  shr_atomic_count
+#elif defined(SMARTPOINTER_ATOMIC_COUNT)
+#define SMARTPOINTER_COUNT_POLICY shr_atomic_count
+#else
+#define SMARTPOINTER_COUNT_POLICY shr_plain_count
+#endif
+
+#ifndef SMARTPOINTER_ISHR_POLICY
+#define SMARTPOINTER_ISHR_POLICY  SMARTPOINTER_COUNT_POLICY
+#endif
+
+// The NULL check made when dereferencing any smart pointer whose type does
+//   not explicitly select one (see smrt_checking<T> below).  By default a
+//   std::runtime_error is thrown.  Define one of the following to change it:
+//     SMARTPOINTER_CHECK_ASSERT : assert() in debug builds, no check with NDEBUG
+//     SMARTPOINTER_CHECK_TRAP   : abort through a trap instruction
+//     SMARTPOINTER_CHECK_NONE   : no check at all
+
+#if   defined(SMARTPOINTER_CHECK_ASSERT)
+#define SMARTPOINTER_CHECK_POLICY smrt_check_assert
+#elif defined(SMARTPOINTER_CHECK_TRAP)
+#define SMARTPOINTER_CHECK_POLICY smrt_check_trap
+#elif defined(SMARTPOINTER_CHECK_NONE)
+#define SMARTPOINTER_CHECK_POLICY smrt_check_none
+#else
+#define SMARTPOINTER_CHECK_POLICY smrt_check_throw
+#endif
+
+// Define SMARTPOINTER_DEFERRED_DELETE to hand every object released by an
+//   own<T>, shr<T>, or ishr<T> to the reclaimer (see smrt_reclaiming<T>
+//   below) rather than deleting it on the releasing thread.  At most
+//   SMARTPOINTER_RECLAIM_CAPACITY deletes may be pending at once.
+
+#ifdef SMARTPOINTER_DEFERRED_DELETE
+#define SMARTPOINTER_RECLAIM_POLICY smrt_reclaim_deferred
+#else
+#define SMARTPOINTER_RECLAIM_POLICY smrt_reclaim_now
+#endif
+
+#ifndef SMARTPOINTER_RECLAIM_CAPACITY
+#define SMARTPOINTER_RECLAIM_CAPACITY 8192
+#endif
+
+// The number of nodes a thread retires from atomic_shr<T> cells before it
+//   scans the hazard pointers of all threads to free those no longer in use
+
+#ifndef SMARTPOINTER_HAZARD_SCAN
+#define SMARTPOINTER_HAZARD_SCAN 64
+#endif
+
+// The number of objects a thread retires to the epoch domain before it
+//   tries to advance the epoch and free those which are no longer in use
+
+#ifndef SMARTPOINTER_EPOCH_SCAN
+#define SMARTPOINTER_EPOCH_SCAN 64
+#endif
+
+// The number of possible roots of garbage cycles a thread may buffer before
+//   those found to be live or already freed are dropped from its buffer
+//   (see shr_cycles below)
+
+#ifndef SMARTPOINTER_CYCLE_ROOTS
+#define SMARTPOINTER_CYCLE_ROOTS 4096
+#endif
+
+// The size of the buffer through which smrt_writer and smrt_reader pass
+//   the stream to and from their file descriptor
+
+#ifndef SMARTPOINTER_IO_BUFFER
+#define SMARTPOINTER_IO_BUFFER 65536
+#endif
+
+// Branch prediction hints for the checks above, and a prefetch for write
+//   of the control blocks touched by the bulk range operations
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SMARTPOINTER_LIKELY(x)   __builtin_expect(!!(x),1)
+#define SMARTPOINTER_UNLIKELY(x) __builtin_expect(!!(x),0)
+#define SMARTPOINTER_COLD        __attribute__((noinline,cold))
+#define SMARTPOINTER_PREFETCH(p) __builtin_prefetch((p),1)
+#else
+#define SMARTPOINTER_LIKELY(x)   (x)
+#define SMARTPOINTER_UNLIKELY(x) (x)
+#define SMARTPOINTER_COLD
+#define SMARTPOINTER_PREFETCH(p) ((void)0)
+#endif
+
+// Define SMARTPOINTER_POOLED_COUNT to allocate the reference counts of all
+//   shr<T> from the slab pool (see shr_pooling<T> below).  The slot
+//   alignment and the size of the pages carved into slots may be tuned.
+
+#ifdef SMARTPOINTER_POOLED_COUNT
+#define SMARTPOINTER_POOLED_DEFAULT true
+#else
+#define SMARTPOINTER_POOLED_DEFAULT false
+#endif
+
+#ifndef SMARTPOINTER_SLAB_ALIGN
+#define SMARTPOINTER_SLAB_ALIGN 64
+#endif
+
+#ifndef SMARTPOINTER_SLAB_PAGE
+#define SMARTPOINTER_SLAB_PAGE 65536
+#endif
+
+// The number of free blocks each thread, and the depot shared by all
+//   threads, may keep for reuse by make_recycled_shr<T> (see 
+//   shr_recycler<T> below).  Both may be changed per type at run time.
+
+#ifndef SMARTPOINTER_RECYCLE_THREAD
+#define SMARTPOINTER_RECYCLE_THREAD 256
+#endif
+
+#ifndef SMARTPOINTER_RECYCLE_SHARED
+#define SMARTPOINTER_RECYCLE_SHARED 4096
+#endif
+
+// The default alignment of arrays from make_aligned_own<T> and its
+//   siblings, enough for the widest (64 byte) vector loads
+
+#ifndef SMARTPOINTER_ARRAY_ALIGN
+#define SMARTPOINTER_ARRAY_ALIGN 64
+#endif
+
+// Define SMARTPOINTER_STATS to count the objects and reference count
+//   operations of the smart pointers to every type (see smrt_tracking<T>
+//   below).  Otherwise the counting compiles away entirely.
+
+#ifdef SMARTPOINTER_STATS
+#define SMARTPOINTER_STATS_DEFAULT true
+#else
+#define SMARTPOINTER_STATS_DEFAULT false
+#endif
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #ifdef NS
 namespace NS {
 #endif
 
+  ////////////////////////////////////////////////////////////////////////////////
+  // NULL checking policies used when dereferencing a smart pointer
+  //
+  //   check(p) : called by operator* and operator-> before returning p
+  //
+  // The failure paths are kept out of line so that the check inlines to
+  //   a single compare and a branch which is predicted not taken.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  struct smrt_check_throw
+  {
+    static void check(const void *p) { if( SMARTPOINTER_UNLIKELY(p==NULL) ) fail(); }
+
+    SMARTPOINTER_COLD static void fail(void)
+    {
+      throw std::runtime_error("Attempting to dereference NULL smart pointer");
+    }
+  };
+
+  struct smrt_check_assert
+  {
+    static void check(const void *p) { assert(p!=NULL && "Attempting to dereference NULL smart pointer"); (void)p; }
+  };
+
+  struct smrt_check_trap
+  {
+    static void check(const void *p) { if( SMARTPOINTER_UNLIKELY(p==NULL) ) fail(); }
+
+    SMARTPOINTER_COLD static void fail(void)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_trap();
+#else
+      std::abort();
+#endif
+    }
+  };
+
+  struct smrt_check_none
+  {
+    static void check(const void *) {}
+  };
+
+  //------------------------------------------------------------
+  // Specialize smrt_checking<T> to select the NULL check for a single
+  //   type, e.g.
+  //     template <> struct smrt_checking<Foo> { typedef smrt_check_none Policy_t; };
+  //------------------------------------------------------------
+  template <typename T>
+    struct smrt_checking
+    {
+      typedef SMARTPOINTER_CHECK_POLICY Policy_t;
+    };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Deferred reclamation of released objects
+  //
+  //   The last owner of an object normally deletes it at once, so the
+  //   thread which happens to drop the last reference pays for the whole
+  //   destructor (including any object graph it releases in turn).  The
+  //   reclaimer instead queues the delete, to be run either by a background
+  //   thread (start/stop) or by whichever thread calls drain().
+  //
+  //   The queue holds at most SMARTPOINTER_RECLAIM_CAPACITY deletes.  When
+  //   it is full, the delete is run at once by the releasing thread, so
+  //   memory held by pending deletes stays bounded.  Deletes are also run
+  //   at once after static destruction has begun.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  struct smrt_reclaim_stats
+  {
+    unsigned long capacity;    // deletes which may be pending at once
+    unsigned long depth;       // deletes currently pending
+    unsigned long highWater;   // greatest depth seen
+    unsigned long deferred;    // deletes queued
+    unsigned long inlined;     // deletes run at once because the queue was full
+    unsigned long reclaimed;   // queued deletes taken from the queue and run
+    bool          running;     // true while the background thread is active
+  };
+
+  class smrt_reclaimer
+  {
+    private: static const std::size_t Capacity = SMARTPOINTER_RECLAIM_CAPACITY;
+    private: static const std::size_t Batch    = 64;
+
+    private: struct Entry
+             {
+               void (*fn)(void*);
+               void  *arg;
+             };
+
+    private: struct State
+             {
+               std::mutex              lock;
+               std::condition_variable wake;
+               Entry                   ring[Capacity];
+               std::size_t             head;
+               std::size_t             depth;
+               smrt_reclaim_stats      stats;
+               bool                    closed;     // static destruction has begun
+               bool                    waiting;    // background thread is asleep
+               bool                    stopping;
+               std::mutex              control;    // serializes start() and stop()
+               std::thread             thread;
+             };
+
+    // Stops the background thread and runs any pending deletes at exit
+
+    private: struct Closer
+             {
+               ~Closer()
+               {
+                 stop();
+                 drain();
+                 State &s = state();
+                 std::lock_guard<std::mutex> guard(s.lock);
+                 s.closed = true;
+               }
+             };
+
+    // Public Methods
+
+    // Runs fn(arg) on the reclaimer, or at once if the queue is full
+
+    public: static void defer(void (*fn)(void*), void *arg)
+            {
+              State &s = state();
+              bool   notify;
+              {
+                std::lock_guard<std::mutex> guard(s.lock);
+                if( s.closed || s.depth == Capacity )
+                {
+                  s.stats.inlined += 1;
+                  notify = false;
+                }
+                else
+                {
+                  Entry &e = s.ring[ (s.head + s.depth) % Capacity ];
+                  e.fn  = fn;
+                  e.arg = arg;
+                  s.depth += 1;
+                  s.stats.deferred += 1;
+                  if( s.depth > s.stats.highWater ) s.stats.highWater = s.depth;
+                  notify = s.waiting;
+                  fn = NULL;
+                }
+              }
+              if( notify )    s.wake.notify_one();
+              if( fn != NULL ) fn(arg);
+            }
+
+    //------------------------------------------------------------
+    // Runs up to max pending deletes on the calling thread and returns
+    //   the number run.  Deletes queued by those being run are included.
+    //------------------------------------------------------------
+    public: static unsigned long drain(unsigned long max=~0UL)
+            {
+              State &s = state();
+              unsigned long rval = 0;
+              while( rval < max )
+              {
+                Entry       batch[Batch];
+                std::size_t n = 0;
+                {
+                  std::lock_guard<std::mutex> guard(s.lock);
+                  while( n < Batch && s.depth > 0 && rval+n < max )
+                  {
+                    batch[n++] = s.ring[s.head];
+                    s.head   = (s.head + 1) % Capacity;
+                    s.depth -= 1;
+                  }
+                  s.stats.reclaimed += n;
+                }
+                if( n == 0 ) break;
+                for(std::size_t i=0; i<n; ++i) batch[i].fn(batch[i].arg);
+                rval += n;
+              }
+              return rval;
+            }
+
+    // Starts the background thread (if not already running)
+
+    public: static void start(void)
+            {
+              State &s = state();
+              std::lock_guard<std::mutex> guard(s.control);
+              if( s.thread.joinable() ) return;
+              {
+                std::lock_guard<std::mutex> g(s.lock);
+                if( s.closed ) return;
+                s.stopping      = false;
+                s.stats.running = true;
+              }
+              s.thread = std::thread(&smrt_reclaimer::run);
+            }
+
+    // Stops the background thread once the queue is empty
+
+    public: static void stop(void)
+            {
+              State &s = state();
+              std::lock_guard<std::mutex> guard(s.control);
+              if( ! s.thread.joinable() ) return;
+              {
+                std::lock_guard<std::mutex> g(s.lock);
+                s.stopping = true;
+              }
+              s.wake.notify_one();
+              s.thread.join();
+              std::lock_guard<std::mutex> g(s.lock);
+              s.stats.running = false;
+            }
+
+    public: static smrt_reclaim_stats stats(void)
+            {
+              State &s = state();
+              std::lock_guard<std::mutex> guard(s.lock);
+              smrt_reclaim_stats rval = s.stats;
+              rval.depth = s.depth;
+              return rval;
+            }
+
+    // Internal Methods
+
+    private: static State &state(void)
+             {
+               static State *s = create();   // never deleted, may outlive static pointers
+               static Closer c;
+               (void)c;
+               return *s;
+             }
+
+    private: static State *create(void)
+             {
+               State *s = new State;
+               s->head     = 0;
+               s->depth    = 0;
+               s->closed   = false;
+               s->waiting  = false;
+               s->stopping = false;
+               s->stats    = smrt_reclaim_stats();
+               s->stats.capacity = Capacity;
+               return s;
+             }
+
+    private: static void run(void)
+             {
+               State &s = state();
+               for(;;)
+               {
+                 {
+                   std::unique_lock<std::mutex> guard(s.lock);
+                   while( s.depth == 0 && ! s.stopping )
+                   {
+                     s.waiting = true;
+                     s.wake.wait(guard);
+                     s.waiting = false;
+                   }
+                   if( s.depth == 0 ) return;
+                 }
+                 drain(Batch);
+               }
+             }
+  };
+
+  //------------------------------------------------------------
+  // Reclamation policies
+  //
+  //   reclaim(f,x) : f(x) releases an object, to be called now or later
+  //------------------------------------------------------------
+
+  struct smrt_reclaim_now
+  {
+    static void reclaim(void (*f)(void*), void *x) { f(x); }
+  };
+
+  struct smrt_reclaim_deferred
+  {
+    static void reclaim(void (*f)(void*), void *x) { smrt_reclaimer::defer(f,x); }
+  };
+
+  //------------------------------------------------------------
+  // Specialize smrt_reclaiming<T> to select when objects of a single type
+  //   are deleted, e.g.
+  //     template <> struct smrt_reclaiming<Foo> { typedef smrt_reclaim_deferred Policy_t; };
+  //------------------------------------------------------------
+  template <typename T>
+    struct smrt_reclaiming
+    {
+      typedef SMARTPOINTER_RECLAIM_POLICY Policy_t;
+    };
+
+  template <typename T>
+    void smrt_delete(void *p) { delete static_cast<T*>(p); }
+
+  // Deletes p according to the reclamation policy for T
+
+  template <typename T>
+    void smrt_reclaim(const T *p)
+    {
+      smrt_reclaiming<T>::Policy_t::reclaim( &smrt_delete<T>, const_cast<T*>(p) );
+    }
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Per type statistics
+  //
+  //   For each tracked type T, smrt_stats<T> counts the objects placed under
+  //   (and deleted by) own<T>, shr<T>, ishr<T> and cshr<T>, the control
+  //   blocks allocated, and the reference count increments and decrements.  The
+  //   objects are counted in shared atomics, as each comes and goes along
+  //   with an allocation anyway.  The far more frequent count operations are
+  //   counted by each thread in a record of its own, without any atomic
+  //   read-modify-write, and the records are summed when read.  Records are
+  //   never freed but are reused by new threads, so the counts made by a
+  //   thread which has exited are kept.
+  //
+  //   The array forms are tracked as a type of their own, e.g. float[].
+  ////////////////////////////////////////////////////////////////////////////////
+
+  struct smrt_type_stats
+  {
+    const char   *name;       // typeid(T).name()
+    unsigned long adopted;    // objects placed under a smart pointer
+    unsigned long deleted;    // objects deleted by a smart pointer
+    unsigned long live;       // adopted but not yet deleted
+    unsigned long peak;       // the most live at once
+    unsigned long ctrls;      // shr<T> control blocks allocated
+    unsigned long incrs;      // reference count increments
+    unsigned long decrs;      // reference count decrements
+  };
+
+  //------------------------------------------------------------
+  // Each tracked type registers itself here when first used, so that
+  //   dump() can write the statistics of all of them, one line per type
+  //------------------------------------------------------------
+  class smrt_stats_registry
+  {
+    public: struct Entry
+            {
+              smrt_type_stats (*stats)(void);
+              Entry            *next;
+            };
+
+    public: static void add(Entry *e)
+            {
+              std::atomic<Entry*> &h = head();
+              e->next = h.load(std::memory_order_relaxed);
+              while( ! h.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed) ) {}
+            }
+
+    // Writes every tracked type, in the order in which they were first used
+
+    public: static void dump(std::ostream &s)
+            {
+              std::vector<Entry*> entries;
+              for(Entry *e = head().load(std::memory_order_acquire); e != NULL; e = e->next) entries.push_back(e);
+              for(std::size_t i=entries.size(); i>0; --i) write(s, entries[i-1]->stats());
+            }
+
+    public: static void write(std::ostream &s, const smrt_type_stats &x)
+            {
+              s << name(x.name) << ": adopted=" << x.adopted << " deleted=" << x.deleted 
+                << " live=" << x.live << " peak=" << x.peak << " ctrls=" << x.ctrls 
+                << " incrs=" << x.incrs << " decrs=" << x.decrs << std::endl;
+            }
+
+    public: static std::string name(const char *mangled)
+            {
+#if defined(__GNUC__) || defined(__clang__)
+              int   status = 0;
+              char *d      = abi::__cxa_demangle(mangled, NULL, NULL, &status);
+              if( d != NULL ) { std::string rval(d); std::free(d); return rval; }
+#endif
+              return mangled;
+            }
+
+    private: static std::atomic<Entry*> &head(void)
+             {
+               static std::atomic<Entry*> h(NULL);
+               return h;
+             }
+  };
+
+  //------------------------------------------------------------
+  // Specialize smrt_tracking<T> to count the smart pointers of a single
+  //   type (or to leave it out), e.g.
+  //     template <> struct smrt_tracking<Foo> { static const bool value = true; };
+  //------------------------------------------------------------
+  template <typename T>
+    struct smrt_tracking
+    {
+      static const bool value = SMARTPOINTER_STATS_DEFAULT;
+    };
+
+  template <typename T, bool On = smrt_tracking<T>::value>
+    class smrt_stats
+    {
+      private: enum Counter { Ctrls, Incrs, Decrs, Counters };
+
+      private: struct Record
+               {
+                 std::atomic<unsigned long> count[Counters];
+                 std::atomic<bool>          active;
+                 Record                    *next;
+               };
+
+      private: struct Domain
+               {
+                 std::atomic<Record*>        head;
+                 std::atomic<unsigned long>  adopted;
+                 std::atomic<unsigned long>  deleted;
+                 std::atomic<unsigned long>  live;
+                 std::atomic<unsigned long>  peak;
+                 Record                      shared;    // used by threads which have exited
+                 smrt_stats_registry::Entry  entry;
+               };
+
+      // The calling thread's record (see smrt_hazard for the pattern)
+
+      private: enum State { New, Active, Dead };
+
+      private: struct Local
+               {
+                 Record *record;
+                 State   state;
+               };
+
+      private: struct Reaper
+               {
+                 ~Reaper()
+                 {
+                   Local &l = local();
+                   l.record->active.store(false, std::memory_order_release);
+                   l.record = NULL;
+                   l.state  = Dead;
+                 }
+               };
+
+      // Hooks called by the smart pointers
+
+      public: static void adopt(void)
+              {
+                Domain       &d = domain();
+                unsigned long n = d.live.fetch_add(1, std::memory_order_relaxed) + 1;
+                unsigned long p = d.peak.load(std::memory_order_relaxed);
+                d.adopted.fetch_add(1, std::memory_order_relaxed);
+                while( n > p && ! d.peak.compare_exchange_weak(p, n, std::memory_order_relaxed) ) {}
+              }
+
+      public: static void dispose(void)
+              {
+                Domain &d = domain();
+                d.live.fetch_sub(1, std::memory_order_relaxed);
+                d.deleted.fetch_add(1, std::memory_order_relaxed);
+              }
+
+      public: static void ctrl(void) { bump(Ctrls); }
+      public: static void incr(void) { bump(Incrs); }
+      public: static void decr(void) { bump(Decrs); }
+
+      public: static void incr(unsigned long n) { bump(Incrs, n); }
+      public: static void decr(unsigned long n) { bump(Decrs, n); }
+
+      // Public Methods
+
+      public: static smrt_type_stats stats(void)
+              {
+                Domain         &d    = domain();
+                unsigned long   c[Counters];
+                for(int i=0; i<Counters; ++i) c[i] = d.shared.count[i].load(std::memory_order_relaxed);
+                for(Record *r = d.head.load(std::memory_order_acquire); r != NULL; r = r->next)
+                {
+                  for(int i=0; i<Counters; ++i) c[i] += r->count[i].load(std::memory_order_relaxed);
+                }
+
+                smrt_type_stats rval;
+                rval.name    = typeid(T).name();
+                rval.adopted = d.adopted.load(std::memory_order_relaxed);
+                rval.deleted = d.deleted.load(std::memory_order_relaxed);
+                rval.live    = d.live.load(std::memory_order_relaxed);
+                rval.peak    = d.peak.load(std::memory_order_relaxed);
+                rval.ctrls   = c[Ctrls];
+                rval.incrs   = c[Incrs];
+                rval.decrs   = c[Decrs];
+                return rval;
+              }
+
+      public: static void dump(std::ostream &s) { smrt_stats_registry::write(s, stats()); }
+
+      // Internal Methods
+
+      private: static Domain &domain(void)
+               {
+                 static Domain *d = create();   // never deleted, may outlive static pointers
+                 return *d;
+               }
+
+      private: static Domain *create(void)
+               {
+                 Domain *d = new Domain;
+                 d->head.store(NULL);
+                 d->adopted.store(0);
+                 d->deleted.store(0);
+                 d->live.store(0);
+                 d->peak.store(0);
+                 for(int i=0; i<Counters; ++i) d->shared.count[i].store(0);
+                 d->entry.stats = &stats;
+                 smrt_stats_registry::add(&d->entry);
+                 return d;
+               }
+
+      private: static Local &local(void)
+               {
+                 static thread_local Local l = { NULL, New };
+                 return l;
+               }
+
+      // Only the owning thread writes to its record, so a plain load and
+      //   store suffice
+
+      private: static void bump(Counter i, unsigned long n=1)
+               {
+                 Record *r = local().record;
+                 if( SMARTPOINTER_UNLIKELY(r == NULL) ) { bumpSlow(i,n); return; }
+                 r->count[i].store(r->count[i].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+               }
+
+      private: SMARTPOINTER_COLD static void bumpSlow(Counter i, unsigned long n)
+               {
+                 Local &l = local();
+                 if( l.state == Dead ) { domain().shared.count[i].fetch_add(n, std::memory_order_relaxed); return; }
+
+                 static thread_local Reaper reaper;
+                 (void)reaper;
+                 l.record = acquire();
+                 l.state  = Active;
+                 l.record->count[i].fetch_add(n, std::memory_order_relaxed);
+               }
+
+      private: static Record *acquire(void)
+               {
+                 Domain &d = domain();
+                 for(Record *r = d.head.load(std::memory_order_acquire); r != NULL; r = r->next)
+                 {
+                   bool idle = false;
+                   if( ! r->active.load(std::memory_order_relaxed) &&
+                       r->active.compare_exchange_strong(idle, true, std::memory_order_acquire) ) return r;
+                 }
+
+                 Record *r = new Record;
+                 for(int i=0; i<Counters; ++i) r->count[i].store(0, std::memory_order_relaxed);
+                 r->active.store(true, std::memory_order_relaxed);
+                 r->next = d.head.load(std::memory_order_relaxed);
+                 while( ! d.head.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed) ) {}
+                 return r;
+               }
+    };
+
+  //------------------------------------------------------------
+  // Untracked types, for which every hook is empty
+  //------------------------------------------------------------
+  template <typename T>
+    class smrt_stats<T,false>
+    {
+      public: static void adopt(void)   {}
+      public: static void dispose(void) {}
+      public: static void ctrl(void)    {}
+      public: static void incr(void)    {}
+      public: static void decr(void)    {}
+
+      public: static void incr(unsigned long) {}
+      public: static void decr(unsigned long) {}
+
+      public: static smrt_type_stats stats(void)
+              {
+                smrt_type_stats rval = { typeid(T).name(), 0, 0, 0, 0, 0, 0, 0 };
+                return rval;
+              }
+
+      public: static void dump(std::ostream &s) { smrt_stats_registry::write(s, stats()); }
+    };
+
+
+  //------------------------------------------------------------
+  // Enables the implicit conversions from a smart pointer to U to one to
+  //   T, which are allowed exactly when a U* converts to a T* (U derives
+  //   from T, or is T itself)
+  //------------------------------------------------------------
+  template <typename U, typename T>
+    struct smrt_upcast : std::enable_if< std::is_convertible<U*,T*>::value > {};
+
   template <typename T>
     class smrt
     {
@@ -43,8 +815,7 @@ namespace NS {
 
       protected: void validate(void) const
                  {
-                   if(_ptr==NULL) 
-                     throw std::runtime_error("Attempting to dereference NULL smart pointer");
+                   smrt_checking<T>::Policy_t::check(_ptr);
                  }
 
       // Attributes
@@ -52,44 +823,107 @@ namespace NS {
       protected: const T *_ptr;
     };
 
+  ////////////////////////////////////////////////////////////////////////////////
+  // Deleters for own<T,D> and shr<T>
+  //
+  //   A deleter is any copyable D for which d(p) disposes of a T* p.  The
+  //   default deleter deletes p according to the reclamation policy for T
+  //   (see smrt_reclaiming<T>).  Any other deleter is called directly.
+  ////////////////////////////////////////////////////////////////////////////////
+
   template <typename T>
-    class const_own : public smrt<T>
+    struct smrt_deleter
     {
-      typedef const_own<T>  Type_t;
-      typedef smrt<T>       Parent_t;
+      void operator()(const T *p) const { smrt_reclaim(p); }
+    };
+
+  //------------------------------------------------------------
+  // Holds a deleter or allocator.  Stateless ones are held as an empty
+  //   base class so that they take no space in the holder.
+  //------------------------------------------------------------
+  template <typename D, bool Empty = std::is_empty<D>::value && ! std::is_final<D>::value>
+    class smrt_ebo : private D
+    {
+      public: smrt_ebo(const D &d) : D(d) {}
+
+      public: D       &get(void)       { return *this; }
+      public: const D &get(void) const { return *this; }
+    };
+
+  template <typename D>
+    class smrt_ebo<D,false>
+    {
+      public: smrt_ebo(const D &d) : _d(d) {}
+
+      public: D       &get(void)       { return _d; }
+      public: const D &get(void) const { return _d; }
+
+      private: D _d;
+    };
+
+  template <typename T, typename D = smrt_deleter<T> >
+    class const_own : public smrt<T>, private smrt_ebo<D>
+    {
+      typedef const_own<T,D>  Type_t;
+      typedef smrt<T>         Parent_t;
+      typedef smrt_ebo<D>     Deleter_t;
+
+      template <typename U> friend class const_shr;
+      template <typename U> friend class epoch_own;
 
       // Constructors and Assignment
 
-      public:  const_own(const T *p=NULL) { this->_ptr = p; }
+      public:  const_own(const T *p=NULL, const D &d=D()) : Deleter_t(d) { this->_ptr = p; if(p != NULL) smrt_stats<T>::adopt(); }
+      public:  const_own(Type_t &&p) noexcept : Deleter_t(std::move(p.deleter())) { this->_ptr = p._ptr; p._ptr = NULL; }
 
       public: Type_t &operator=(const T* p) 
               { 
-                if(this->_ptr != p && this->_ptr != NULL) delete this->_ptr;
+                if(this->_ptr == p) return *this;
+                if(this->_ptr != NULL) dispose();
+                if(p != NULL)          smrt_stats<T>::adopt();
                 this->_ptr = p;
                 return *this;
               }
 
+      public: Type_t &operator=(Type_t &&p) noexcept
+              {
+                if(this != &p) { release(); deleter() = std::move(p.deleter()); this->_ptr = p._ptr; p._ptr = NULL; }
+                return *this;
+              }
+
+      private: const_own(const Type_t &p);
       private: Type_t &operator=(const Type_t  &p);
 
-      public: ~const_own() { if(this->_ptr != NULL) delete this->_ptr; }
+      public: ~const_own() { if(this->_ptr != NULL) dispose(); }
+
+      public: void release(void) { if(this->_ptr != NULL) dispose(); this->_ptr = NULL; }
 
-      public: void release(void) { if(this->_ptr != NULL) delete this->_ptr; this->_ptr = NULL; }
+      public: D       &deleter(void)       { return Deleter_t::get(); }
+      public: const D &deleter(void) const { return Deleter_t::get(); }
+
+      // Internal Methods
+
+      private: void dispose(void) { smrt_stats<T>::dispose(); deleter()( const_cast<T*>(this->_ptr) ); }
     };
 
-  template <typename T>
-    class own : public const_own<T>
+  template <typename T, typename D = smrt_deleter<T> >
+    class own : public const_own<T,D>
     {
-      typedef       own<T> Type_t;
-      typedef const_own<T> Parent_t;
-      typedef      smrt<T> Base_t;
+      typedef       own<T,D> Type_t;
+      typedef const_own<T,D> Parent_t;
+      typedef        smrt<T> Base_t;
 
       using Base_t::validate;
 
       // Constructors and Assignment
 
-      public:  own(T *p=NULL) : Parent_t(p) {}
+      public:  own(T *p=NULL, const D &d=D()) : Parent_t(p,d) {}
+      public:  own(Type_t &&p) noexcept       : Parent_t(std::move(p)) {}
+
+      public:  Type_t &operator=(T* p)               { Parent_t::operator=(p);            return *this; }
+      public:  Type_t &operator=(Type_t &&p) noexcept { Parent_t::operator=(std::move(p)); return *this; }
 
-      public:  Type_t &operator=(T* p) { Parent_t::operator=(p); return *this; }
+      private: own(const Type_t &p);
       private: Type_t &operator=(const Type_t  &p);
 
       // Methods
@@ -105,136 +939,4923 @@ namespace NS {
       public:    T *raw(void)        const {             return  const_cast<T*>(this->_ptr); }
     };
 
-
-  template <typename T>
-    class const_shr : public smrt<T>
+  //------------------------------------------------------------
+  // Deleter for objects obtained from an allocator (see allocate_own<T>).
+  //   It is empty, and so takes no space in an own<T,D>, whenever the
+  //   allocator is.
+  //------------------------------------------------------------
+  template <typename T, typename A>
+    class smrt_alloc_delete : private smrt_ebo< typename std::allocator_traits<A>::template rebind_alloc<T> >
     {
-      typedef const_shr<T>  Type_t;
-      typedef smrt<T>       Parent_t;
+      public: typedef typename std::allocator_traits<A>::template rebind_alloc<T> Alloc_t;
+      public: typedef std::allocator_traits<Alloc_t>                              Traits_t;
 
-      // Constructors and Assignment
+      public: smrt_alloc_delete(const A &a=A()) : smrt_ebo<Alloc_t>( Alloc_t(a) ) {}
 
-      public: const_shr(const T *p=NULL) : _refCount(NULL) { set(p); }
-      public: const_shr(const Type_t &p) : _refCount(NULL) { set(p); }
+      public: void operator()(T *p)
+              {
+                Alloc_t &a = this->get();
+                Traits_t::destroy(a, p);
+                Traits_t::deallocate(a, p, 1);
+              }
 
-      public: ~const_shr() { decr(); }
+      public: const Alloc_t &allocator(void) const { return this->get(); }
+    };
 
-      public: void release(void) { set(NULL); }
 
-      public: Type_t &operator=(const T*  p)     { set(p); return *this; }
-      public: Type_t &operator=(const Type_t &p) { set(p); return *this; }
+  ////////////////////////////////////////////////////////////////////////////////
+  // Reference counting policies for shr<T> and const_shr<T>
+  //
+  //   Count_t        : the type of the shared counter
+  //   init(c)        : sets a new counter to 1
+  //   incr(c)        : adds a reference
+  //   decr(c)        : removes a reference, returns true if it was the last one
+  //   add(c,n)       : adds n references at once
+  //   sub(c,n)       : removes n references at once, true if they were the last
+  //   incrNonZero(c) : adds a reference unless the count is already zero
+  //   value(c)       : current count (a snapshot only in the atomic case)
+  //   bind(c,f,x)    : f(x) is to be called if the count is ever found to have
+  //                    reached zero other than by decr() returning true
+  //   WeakPolicy_t   : the policy used for the weak_shr<T> count
+  //   thread_safe    : true if copies sharing a count may be made and
+  //                    released by different threads at once
+  //
+  // The plain and atomic policies are also available with a 32-bit count
+  //   (shr_plain_count32 and shr_atomic_count32) for counts embedded in
+  //   small objects (see cshr<T>).  It is up to the caller to ensure that
+  //   an object never has 2^32 references.
+  ////////////////////////////////////////////////////////////////////////////////
 
-      // Public Methods
+  template <typename N>
+    struct shr_plain_count_n
+    {
+      typedef N                    Count_t;
+      typedef shr_plain_count_n<N> WeakPolicy_t;
 
-      public: unsigned long refCount(void) const { return ( _refCount ? *_refCount : 0UL ); }
+      static const bool thread_safe = false;
 
-      // Internal Methods
+      static void          init(Count_t &c)        { c = 1; }
+      static void          bind(Count_t &, void (*)(void*), void *) {}
+      static void          incr(Count_t &c)        { c += 1; }
+      static bool          decr(Count_t &c)        { return (c -= 1) == 0; }
+      static void          add(Count_t &c, N n)    { c += n; }
+      static bool          sub(Count_t &c, N n)    { return (c -= n) == 0; }
+      static bool          incrNonZero(Count_t &c) { if(c==0) return false; c += 1; return true; }
+      static unsigned long value(const Count_t &c) { return c; }
+    };
 
-      protected: void set(const T* p)
-                 {
-                   decr();
-                   this->_ptr = p;
-                   if(p!=NULL) { _refCount = new unsigned long; *_refCount = 1; }
-                   else        { _refCount = NULL;                              }
-                 }
+  typedef shr_plain_count_n<unsigned long> shr_plain_count;
+  typedef shr_plain_count_n<std::uint32_t> shr_plain_count32;
 
-      protected: void set(const const_shr<T> &p)
-                 {
-                   decr();
-                   this->_ptr = p._ptr;
-                   if( p.isSet() ) { _refCount = p._refCount; *_refCount += 1; }
-                   else            { _refCount = NULL;                         }
-                 }
+  //------------------------------------------------------------
+  // Increments need no ordering as the thread making the copy already
+  //   holds a reference.  The decrement releases all prior writes to the
+  //   object and the final decrement acquires them before the delete.
+  //------------------------------------------------------------
+  template <typename N>
+    struct shr_atomic_count_n
+    {
+      typedef std::atomic<N>        Count_t;
+      typedef shr_atomic_count_n<N> WeakPolicy_t;
 
-      protected: void decr(void)
-                 {
-                   if( _refCount != NULL )
-                   {
-                     *_refCount -= 1;
-                     if(*_refCount==0) { delete this->_ptr; delete _refCount; this->_ptr = NULL; _refCount = NULL; }
-                   }
-                 }
+      static const bool thread_safe = true;
 
-      // Attributes
+      static void          init(Count_t &c)        { c.store(1, std::memory_order_relaxed); }
+      static void          bind(Count_t &, void (*)(void*), void *) {}
+      static void          incr(Count_t &c)        { c.fetch_add(1, std::memory_order_relaxed); }
+      static void          add(Count_t &c, N n)    { c.fetch_add(n, std::memory_order_relaxed); }
+      static unsigned long value(const Count_t &c) { return c.load(std::memory_order_relaxed); }
 
-      protected: unsigned long *_refCount;
-    };
+      static bool decr(Count_t &c) { return sub(c, 1); }
 
-  template <typename T>
-    class shr : public const_shr<T>
-    {
-      typedef       shr<T> Type_t;
-      typedef const_shr<T> Parent_t;
-      typedef      smrt<T> Base_t;
+      static bool sub(Count_t &c, N n)
+      {
+        if( c.fetch_sub(n, std::memory_order_release) != n ) return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+      }
 
-      using Base_t::_ptr;
-      using Base_t::validate;
+      static bool incrNonZero(Count_t &c)
+      {
+        N n = c.load(std::memory_order_relaxed);
+        do { if(n==0) return false; } 
+        while( ! c.compare_exchange_weak(n, n+1, std::memory_order_relaxed) );
+        return true;
+      }
+    };
 
-      // Constructors and Assignment
+  typedef shr_atomic_count_n<unsigned long> shr_atomic_count;
+  typedef shr_atomic_count_n<std::uint32_t> shr_atomic_count32;
 
-      public: shr(T *p=NULL)        : Parent_t(p) {}
-      public: shr(const Type_t &p)  : Parent_t(p) {}
+  //------------------------------------------------------------
+  // Biased reference counting
+  //
+  //   Each count is owned by the thread which created it.  The owner
+  //   updates its own local count with plain loads and stores, exactly as
+  //   cheap as shr_plain_count.  All other threads update a shared atomic
+  //   count.  The true count is the sum of the two.
+  //
+  //   When the owner's local count drops to zero, it merges: the local
+  //   count is retired and the shared count becomes the true count.  From
+  //   then on all threads (including the owner) use the shared count.
+  //
+  //   A non-owner may drop a reference that the owner took (e.g. a copy 
+  //   handed to a worker thread), driving the shared count negative.  The
+  //   object can then only be freed after a merge, so it is queued for its
+  //   owner.  The owner merges queued counts whenever it next creates a
+  //   count, drops its own last local reference, calls collect(), or exits.
+  //   Counts queued after their owner exits are merged by the queuing thread.
+  //
+  //   The shared count holds the count (times 4) plus two flags in its low
+  //   bits, so that the count and flags are always updated together.
+  //------------------------------------------------------------
+  struct shr_biased_count
+  {
+    struct Count_t;
+    typedef shr_atomic_count WeakPolicy_t;
 
-      public: Type_t &operator=(T*  p)           { Parent_t::set(p); return *this; }
-      public: Type_t &operator=(const Type_t &p) { Parent_t::set(p); return *this; }
+    static const bool thread_safe = true;
 
-      // Methods (see notes above in own<T> class)
+    // One per thread which has created a count.  It is freed once the thread
+    //   has exited and none of its counts remain unmerged.
 
-      public: T &operator*(void)  const { validate(); return *const_cast<T*>(this->_ptr); }
-      public: T *operator->(void) const { validate(); return  const_cast<T*>(this->_ptr); }
-      public: T *raw(void)        const {             return  const_cast<T*>(this->_ptr); }
+    struct Thread
+    {
+      std::atomic<Count_t*> queue;      // unmerged counts (or Closed)
+      std::atomic<long>     refs;       // unmerged counts + 1 while running
     };
 
+    struct Count_t
+    {
+      Thread             *owner;
+      std::atomic<long>   local;        // owner's count, -1 once merged
+      std::atomic<long>   shared;       // 4*count + flags
+      Count_t            *next;         // link in the owner's queue
+      void              (*zero)(void*); // see bind()
+      void               *arg;
+    };
 
-  template <typename T>
-    class const_ref : public smrt<T>
-    {  
-      typedef const_ref<T>  Type_t;
+    static const long Merged = 1;
+    static const long Queued = 2;
+
+    static long count(long w) { return (w - (w&3)) / 4; }
+
+    // Marks a closed queue and a thread which has already exited
+
+    static Count_t *closed(void) { static Count_t c; return &c; }
+    static Thread  *exited(void) { static Thread  t; return &t; }
+
+    // The Thread for the calling thread (NULL if there is none yet)
+
+    static Thread *&current(void) { static thread_local Thread *t = NULL; return t; }
+
+    struct Reaper
+    {
+      ~Reaper()
+      {
+        Thread *t = current();
+        process( t->queue.exchange(closed(), std::memory_order_acq_rel) );
+        current() = exited();
+        release(t);
+      }
+    };
+
+    static Thread *attach(void)
+    {
+      static thread_local Reaper r;
+      (void)r;
+      Thread *t = new Thread;
+      t->queue.store(NULL, std::memory_order_relaxed);
+      t->refs.store(1, std::memory_order_relaxed);
+      current() = t;
+      return t;
+    }
+
+    static void release(Thread *t)
+    {
+      if( t->refs.fetch_sub(1, std::memory_order_acq_rel) == 1 ) delete t;
+    }
+
+    // Public Methods
+
+    static void init(Count_t &c)
+    {
+      c.next = NULL;
+      c.zero = NULL;
+      c.arg  = NULL;
+
+      Thread *t = current();
+      if( t == NULL ) t = attach();
+
+      // Counts created while a thread is exiting start out merged
+
+      if( t == exited() )
+      {
+        c.owner = NULL;
+        c.local.store(-1, std::memory_order_relaxed);
+        c.shared.store(4+Merged, std::memory_order_relaxed);
+        return;
+      }
+
+      if( t->queue.load(std::memory_order_relaxed) != NULL ) collect();
+
+      t->refs.fetch_add(1, std::memory_order_relaxed);
+      c.owner = t;
+      c.local.store(1, std::memory_order_relaxed);
+      c.shared.store(0, std::memory_order_relaxed);
+    }
+
+    static void bind(Count_t &c, void (*zero)(void*), void *arg) { c.zero = zero; c.arg = arg; }
+
+    static void incr(Count_t &c) { add(c, 1); }
+
+    static void add(Count_t &c, unsigned long n)
+    {
+      long l = c.local.load(std::memory_order_relaxed);
+      if( c.owner == current() && l > 0 ) c.local.store(l+long(n), std::memory_order_relaxed);
+      else                                c.shared.fetch_add(4*long(n), std::memory_order_relaxed);
+    }
+
+    static bool incrNonZero(Count_t &c)
+    {
+      long l = c.local.load(std::memory_order_relaxed);
+      if( c.owner == current() && l > 0 ) { c.local.store(l+1, std::memory_order_relaxed); return true; }
+
+      long w = c.shared.load(std::memory_order_relaxed);
+      do { if( (w & Merged) && count(w) == 0 ) return false; }
+      while( ! c.shared.compare_exchange_weak(w, w+4, std::memory_order_relaxed) );
+      return true;
+    }
+
+    static bool decr(Count_t &c)
+    {
+      long l = c.local.load(std::memory_order_relaxed);
+      if( c.owner == current() && l > 0 )
+      {
+        if( l > 1 ) { c.local.store(l-1, std::memory_order_relaxed); return false; }
+        return merge(c);
+      }
+
+      long w = c.shared.load(std::memory_order_relaxed);
+      long n;
+      do
+      {
+        n = w - 4;
+        if( !(n & Merged) && !(n & Queued) && count(n) < 0 ) n |= Queued;
+      }
+      while( ! c.shared.compare_exchange_weak(w, n, std::memory_order_acq_rel) );
+
+      if( (n & Queued) && !(w & Queued) ) return enqueue(c);
+      return (n & Merged) && !(n & Queued) && count(n) == 0;
+    }
+
+    //------------------------------------------------------------
+    // The owner removes all but the last of n references from its local
+    //   count at once.  Otherwise they are removed one at a time so that
+    //   a count driven negative is still queued for its owner.
+    //------------------------------------------------------------
+    static bool sub(Count_t &c, unsigned long n)
+    {
+      long l = c.local.load(std::memory_order_relaxed);
+      if( n > 1 && c.owner == current() && l > long(n) ) { c.local.store(l-long(n), std::memory_order_relaxed); return false; }
+
+      bool last = false;
+      while( n-- ) last = decr(c);
+      return last;
+    }
+
+    static unsigned long value(const Count_t &c)
+    {
+      long l = c.local.load(std::memory_order_relaxed);
+      long n = count( c.shared.load(std::memory_order_relaxed) ) + ( l > 0 ? l : 0 );
+      return ( n > 0 ? n : 0 );
+    }
+
+    // Merges all counts queued for the calling thread
+
+    static void collect(void)
+    {
+      Thread *t = current();
+      if( t != NULL && t != exited() ) process( t->queue.exchange(NULL, std::memory_order_acq_rel) );
+    }
+
+    // Internal Methods
+
+    // The calling thread is the owner and is dropping its last local reference
+
+    static bool merge(Count_t &c)
+    {
+      c.local.store(-1, std::memory_order_relaxed);
+      long w = c.shared.fetch_add(Merged, std::memory_order_acq_rel) + Merged;
+      if( w & Queued ) { collect(); return false; }
+      release(c.owner);
+      return count(w) == 0;
+    }
+
+    //------------------------------------------------------------
+    // Returns true only if the owner has exited and the count was found
+    //   to be zero when merged here.
+    //------------------------------------------------------------
+    static bool enqueue(Count_t &c)
+    {
+      Thread  *t    = c.owner;
+      Count_t *head = t->queue.load(std::memory_order_acquire);
+      do
+      {
+        if( head == closed() ) return unqueue(c, false);
+        c.next = head;
+      }
+      while( ! t->queue.compare_exchange_weak(head, &c, std::memory_order_acq_rel, std::memory_order_acquire) );
+      return false;
+    }
+
+    static void process(Count_t *c)
+    {
+      while( c != NULL && c != closed() )
+      {
+        Count_t *next = c->next;
+        unqueue(*c, true);
+        c = next;
+      }
+    }
+
+    //------------------------------------------------------------
+    // Merges (if not already merged) a count which was queued for its
+    //   owner and clears its Queued flag.  If the result is zero, the
+    //   object is freed here (via the bound function) or, if called from
+    //   decr(), by returning true.
+    //------------------------------------------------------------
+    static bool unqueue(Count_t &c, bool callZero)
+    {
+      long l   = c.local.load(std::memory_order_relaxed);
+      long add = -Queued;
+      if( l > 0 ) { c.local.store(-1, std::memory_order_relaxed); add += 4*l + Merged; }
+
+      Thread *t = c.owner;
+      long    w = c.shared.fetch_add(add, std::memory_order_acq_rel) + add;
+      release(t);
+
+      if( count(w) != 0 ) return false;
+      if( callZero && c.zero != NULL ) { c.zero(c.arg); return false; }
+      return true;
+    }
+  };
+
+  //------------------------------------------------------------
+  // Specialize shr_counting<T> to select the counting policy for a
+  //   single type, e.g.
+  //     template <> struct shr_counting<Foo> { typedef shr_atomic_count Policy_t; };
+  //------------------------------------------------------------
+  template <typename T>
+    struct shr_counting
+    {
+      typedef SMARTPOINTER_COUNT_POLICY Policy_t;
+    };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Slab pool for fixed size blocks (used for shr<T> reference counts)
+  //
+  //   Slots are rounded up to SMARTPOINTER_SLAB_ALIGN bytes (a cache line
+  //   by default) so that counts used by different threads never share
+  //   a line.  They are carved from SMARTPOINTER_SLAB_PAGE byte pages.
+  //
+  //   Each thread allocates from and frees to its own free list without
+  //   locking.  Only when that list runs dry (or grows too long) is a batch
+  //   of slots exchanged with the shared depot under a mutex.  Pages are
+  //   never returned to the system.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  struct shr_slab_stats
+  {
+    unsigned long slotSize;   // bytes per slot
+    unsigned long pages;      // pages obtained from the system
+    unsigned long reserved;   // bytes obtained from the system
+    unsigned long allocs;     // slots handed out
+    unsigned long frees;      // slots returned
+    unsigned long live;       // slots currently in use (allocs - frees)
+    unsigned long refills;    // batches moved from the depot to a thread
+    unsigned long flushes;    // batches moved from a thread to the depot
+  };
+
+  template <std::size_t Size>
+    class shr_slab
+    {
+      public: static const std::size_t Align = SMARTPOINTER_SLAB_ALIGN;
+      public: static const std::size_t Slot  = (Size + Align - 1) / Align * Align;
+      public: static const std::size_t Batch = 256;
+
+      private: struct Node { Node *next; };
+
+      // Shared by all threads, protected by its mutex
+
+      private: struct Depot
+               {
+                 std::mutex    lock;
+                 Node         *free;
+                 unsigned long pages, allocs, frees, refills, flushes;
+               };
+
+      // One per thread, used without locking.  The Cache has no destructor
+      //   so that it remains usable by other thread_local objects destroyed
+      //   after the Reaper has returned its slots to the depot.
+
+      private: enum State { New, Active, Dead };
+
+      private: struct Cache
+               {
+                 Node         *free;
+                 std::size_t   count;
+                 unsigned long allocs, frees;
+                 State         state;
+               };
+
+      private: struct Reaper { ~Reaper() { flush(cache(), cache().count); cache().state = Dead; } };
+
+      // Public Methods
+
+      public: static void *allocate(void)
+              {
+                Cache &c = cache();
+                if( c.state != Active && !activate(c) ) return allocateShared();
+                if( c.free == NULL ) refill(c);
+                Node *n = c.free;
+                c.free   = n->next;
+                c.count -= 1;
+                c.allocs += 1;
+                return n;
+              }
+
+      public: static void deallocate(void *p)
+              {
+                Cache &c = cache();
+                if( c.state != Active && !activate(c) ) { deallocateShared(p); return; }
+                Node *n = static_cast<Node*>(p);
+                n->next  = c.free;
+                c.free   = n;
+                c.count += 1;
+                c.frees += 1;
+                if( c.count > 2*Batch ) flush(c, Batch);
+              }
+
+      //------------------------------------------------------------
+      // Counts made by other threads are included once those threads
+      //   next exchange a batch with the depot (or exit).
+      //------------------------------------------------------------
+      public: static shr_slab_stats stats(void)
+              {
+                Depot &d = depot();
+                Cache &c = cache();
+                std::lock_guard<std::mutex> guard(d.lock);
+                shr_slab_stats rval;
+                rval.slotSize = Slot;
+                rval.pages    = d.pages;
+                rval.reserved = d.pages * SMARTPOINTER_SLAB_PAGE;
+                rval.allocs   = d.allocs + c.allocs;
+                rval.frees    = d.frees  + c.frees;
+                rval.live     = rval.allocs - rval.frees;
+                rval.refills  = d.refills;
+                rval.flushes  = d.flushes;
+                return rval;
+              }
+
+      // Internal Methods
+
+      private: static Depot &depot(void)
+               {
+                 static Depot *d = new Depot();   // never deleted, may outlive static pointers
+                 return *d;
+               }
+
+      private: static Cache &cache(void)
+               {
+                 static thread_local Cache c = { NULL, 0, 0, 0, New };
+                 return c;
+               }
+
+      private: static bool activate(Cache &c)
+               {
+                 if( c.state == Dead ) return false;
+                 static thread_local Reaper r;
+                 (void)r;
+                 c.state = Active;
+                 return true;
+               }
+
+      private: static void refill(Cache &c)
+               {
+                 Depot &d = depot();
+                 std::lock_guard<std::mutex> guard(d.lock);
+                 if( d.free == NULL ) addPage(d);
+                 for(std::size_t i=0; i<Batch && d.free!=NULL; ++i)
+                 {
+                   Node *n = d.free;
+                   d.free  = n->next;
+                   n->next = c.free;
+                   c.free  = n;
+                   c.count += 1;
+                 }
+                 d.refills += 1;
+                 merge(d,c);
+               }
+
+      private: static void flush(Cache &c, std::size_t n)
+               {
+                 Depot &d = depot();
+                 std::lock_guard<std::mutex> guard(d.lock);
+                 for(std::size_t i=0; i<n && c.free!=NULL; ++i)
+                 {
+                   Node *x = c.free;
+                   c.free  = x->next;
+                   c.count -= 1;
+                   x->next = d.free;
+                   d.free  = x;
+                 }
+                 d.flushes += 1;
+                 merge(d,c);
+               }
+
+      private: static void merge(Depot &d, Cache &c)
+               {
+                 d.allocs += c.allocs;  c.allocs = 0;
+                 d.frees  += c.frees;   c.frees  = 0;
+               }
+
+      private: static void addPage(Depot &d)
+               {
+                 char     *raw   = static_cast<char*>(::operator new(SMARTPOINTER_SLAB_PAGE + Align));
+                 uintptr_t first = (reinterpret_cast<uintptr_t>(raw) + Align - 1) / Align * Align;
+                 char     *slot  = reinterpret_cast<char*>(first);
+                 for(std::size_t i=0; i<SMARTPOINTER_SLAB_PAGE/Slot; ++i, slot+=Slot)
+                 {
+                   Node *n = reinterpret_cast<Node*>(slot);
+                   n->next = d.free;
+                   d.free  = n;
+                 }
+                 d.pages += 1;
+               }
+
+      // Used by threads which have already exited their Reaper
+
+      private: static void *allocateShared(void)
+               {
+                 Depot &d = depot();
+                 std::lock_guard<std::mutex> guard(d.lock);
+                 if( d.free == NULL ) addPage(d);
+                 Node *n = d.free;
+                 d.free  = n->next;
+                 d.allocs += 1;
+                 return n;
+               }
+
+      private: static void deallocateShared(void *p)
+               {
+                 Depot &d = depot();
+                 std::lock_guard<std::mutex> guard(d.lock);
+                 Node *n = static_cast<Node*>(p);
+                 n->next = d.free;
+                 d.free  = n;
+                 d.frees += 1;
+               }
+    };
+
+  //------------------------------------------------------------
+  // Specialize shr_pooling<T> to allocate the reference counts of a
+  //   single type from the slab pool, e.g.
+  //     template <> struct shr_pooling<Foo> { static const bool value = true; };
+  //------------------------------------------------------------
+  template <typename T>
+    struct shr_pooling
+    {
+      static const bool value = SMARTPOINTER_POOLED_DEFAULT;
+    };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Control blocks shared by all shr<T> and const_shr<T> instances which
+  //   reference the same object.  The block holds the reference count and
+  //   knows how to dispose of the object once the count reaches zero.
+  //
+  //   The block also holds a count of weak_shr<T> references, plus one
+  //   for all of the shr<T> references combined.  The block itself is 
+  //   destroyed only when this weak count reaches zero.
+  //
+  //   shr_ctrl_ptr<T,P> : manages a T allocated separately by the caller
+  //   shr_ctrl_obj<T,P> : holds the T itself (see make_shr<T> below)
+  ////////////////////////////////////////////////////////////////////////////////
+
+  class shr_tracer;
+
+  template <typename P>
+    class shr_ctrl
+    {
+      friend class shr_tracer;   // reaches the counts of a cycle collected graph
+
+      public: typedef typename P::Count_t Count_t;
+
+      public: typedef typename P::WeakPolicy_t W;
+
+      public: shr_ctrl(void) { P::init(_count); P::bind(_count, &zero, this); W::init(_weak); }
+
+      protected: virtual ~shr_ctrl() {}
+
+      // Disposes of the managed object and drops the weak count held by the
+      //   strong references, either now or later (see smrt_reclaiming<T>)
+
+      public: virtual void release(void) = 0;
+
+      // Deletes this control block
+
+      public: virtual void destroy(void) = 0;
+
+      public: void          incr(void)           { P::incr(_count); }
+      public: void          decr(void)           { if( P::decr(_count) ) release(); }
+      public: void          add(unsigned long n) { P::add(_count, n); }
+      public: void          sub(unsigned long n) { if( P::sub(_count, n) ) release(); }
+      public: bool          lock(void)           { return P::incrNonZero(_count); }
+      public: unsigned long value(void) const    { return P::value(_count); }
+
+      public: void          incrWeak(void)       { W::incr(_weak); }
+      public: void          decrWeak(void)       { if( W::decr(_weak) ) destroy(); }
+
+      // The release itself, given the concrete block type C
+
+      protected: template <typename C>
+                 static void finish(void *c)  { static_cast<C*>(c)->C::dispose(); static_cast<C*>(c)->decrWeak(); }
+
+      private: static void  zero(void *c)     { static_cast<shr_ctrl*>(c)->release(); }
+
+      private: Count_t                       _count;
+      private: typename W::Count_t           _weak;
+    };
+
+  template <typename T, typename P>
+    class shr_ctrl_ptr : public shr_ctrl<P>
+    {
+      public: shr_ctrl_ptr(const T *p) : _ptr(p) {}
+
+      public: void release(void) { smrt_reclaiming<T>::Policy_t::reclaim( &shr_ctrl<P>::template finish<shr_ctrl_ptr>, this ); }
+      public: void dispose(void) { smrt_stats<T>::dispose(); delete _ptr; }
+      public: void destroy(void) { delete this; }
+
+      public: static void *operator new(std::size_t n)
+              {
+                return ( shr_pooling<T>::value ? shr_slab<sizeof(shr_ctrl_ptr)>::allocate() : ::operator new(n) );
+              }
+
+      public: static void operator delete(void *p)
+              {
+                if( shr_pooling<T>::value ) shr_slab<sizeof(shr_ctrl_ptr)>::deallocate(p);
+                else                        ::operator delete(p);
+              }
+
+      private: const T *_ptr;
+    };
+
+  //------------------------------------------------------------
+  // Manages a T allocated separately, disposed of by a custom deleter.  
+  //   S is the type whose statistics are kept (T[] for arrays of T).
+  //------------------------------------------------------------
+  template <typename T, typename D, typename P, typename S = T>
+    class shr_ctrl_del : public shr_ctrl<P>, private smrt_ebo<D>
+    {
+      public: shr_ctrl_del(const T *p, const D &d) : smrt_ebo<D>(d), _ptr(p) {}
+
+      public: void release(void) { smrt_reclaiming<T>::Policy_t::reclaim( &shr_ctrl<P>::template finish<shr_ctrl_del>, this ); }
+      public: void dispose(void) { smrt_stats<S>::dispose(); this->get()( const_cast<T*>(_ptr) ); }
+      public: void destroy(void) { delete this; }
+
+      private: const T *_ptr;
+    };
+
+  //------------------------------------------------------------
+  // The reference count is placed immediately ahead of the object so that
+  //   both are allocated at once and typically share a cache line.
+  //------------------------------------------------------------
+  template <typename T, typename P>
+    class shr_ctrl_obj : public shr_ctrl<P>
+    {
+      public: template <typename... Args>
+              shr_ctrl_obj(Args&&... args) { new(_obj) T(std::forward<Args>(args)...); }
+
+      public: void release(void) { smrt_reclaiming<T>::Policy_t::reclaim( &shr_ctrl<P>::template finish<shr_ctrl_obj>, this ); }
+      public: void dispose(void) { smrt_stats<T>::dispose(); object()->~T(); }
+      public: void destroy(void) { delete this; }
+
+      public: T *object(void) { return reinterpret_cast<T*>(_obj); }
+
+      // Raw storage so that the T can be destroyed before the block
+
+      private: alignas(T) unsigned char _obj[sizeof(T)];
+    };
+
+  //------------------------------------------------------------
+  // Holds the T and the block itself in memory from an allocator (see
+  //   allocate_shr<T>).  The block is freed through a copy of the
+  //   allocator, rebound to the block type.
+  //------------------------------------------------------------
+  template <typename T, typename A, typename P>
+    class shr_ctrl_alloc : public shr_ctrl<P>,
+                           private smrt_ebo< typename std::allocator_traits<A>::template rebind_alloc< shr_ctrl_alloc<T,A,P> > >
+    {
+      public: typedef typename std::allocator_traits<A>::template rebind_alloc<shr_ctrl_alloc> Alloc_t;
+      public: typedef typename std::allocator_traits<A>::template rebind_alloc<T>              ObjAlloc_t;
+
+      public: template <typename... Args>
+              shr_ctrl_alloc(const A &a, Args&&... args) : smrt_ebo<Alloc_t>( Alloc_t(a) )
+              {
+                ObjAlloc_t o(a);
+                std::allocator_traits<ObjAlloc_t>::construct(o, object(), std::forward<Args>(args)...);
+              }
+
+      public: void release(void) { smrt_reclaiming<T>::Policy_t::reclaim( &shr_ctrl<P>::template finish<shr_ctrl_alloc>, this ); }
+
+      public: void dispose(void)
+              {
+                smrt_stats<T>::dispose();
+                ObjAlloc_t o(this->get());
+                std::allocator_traits<ObjAlloc_t>::destroy(o, object());
+              }
+
+      public: void destroy(void)
+              {
+                Alloc_t a(this->get());
+                this->~shr_ctrl_alloc();
+                std::allocator_traits<Alloc_t>::deallocate(a, this, 1);
+              }
+
+      public: T *object(void) { return reinterpret_cast<T*>(_obj); }
+
+      private: alignas(T) unsigned char _obj[sizeof(T)];
+    };
+
+  //------------------------------------------------------------
+  // Holds n elements of T directly behind the block, in one allocation
+  //   (see make_shr_block<T>).  The elements are destroyed in reverse.
+  //------------------------------------------------------------
+  template <typename T, typename P>
+    class shr_ctrl_block : public shr_ctrl<P>
+    {
+      static_assert( alignof(T) <= alignof(std::max_align_t), "make_shr_block<T> does not support over-aligned T" );
+
+      // Each element is constructed from the same args.  If one throws,
+      //   those already built are destroyed and the memory freed.
+
+      public: template <typename... Args>
+              static shr_ctrl_block *create(std::size_t n, const Args&... args)
+              {
+                if( n > (std::size_t(-1) - offset()) / sizeof(T) ) throw std::bad_alloc();
+
+                void           *m = ::operator new(offset() + n*sizeof(T));
+                shr_ctrl_block *c = ::new(m) shr_ctrl_block();
+                T              *p = c->object();
+                try        { for( ; c->_size<n; ++c->_size) ::new(static_cast<void*>(p + c->_size)) T(args...); }
+                catch(...) { while( c->_size ) p[--c->_size].~T(); c->destroy(); throw; }
+                return c;
+              }
+
+      public: void release(void) { smrt_reclaiming<T>::Policy_t::reclaim( &shr_ctrl<P>::template finish<shr_ctrl_block>, this ); }
+
+      public: void dispose(void)
+              {
+                smrt_stats<T[]>::dispose();
+                T *p = object();
+                while( _size ) p[--_size].~T();
+              }
+
+      public: void destroy(void)
+              {
+                this->~shr_ctrl_block();
+                ::operator delete(static_cast<void*>(this));
+              }
+
+      public: T *object(void) { return reinterpret_cast<T*>( reinterpret_cast<char*>(this) + offset() ); }
+
+      // The elements start at the first multiple of alignof(T) past the block
+
+      private: static std::size_t offset(void) { return (sizeof(shr_ctrl_block) + alignof(T) - 1) / alignof(T) * alignof(T); }
+
+      private: shr_ctrl_block(void) : _size(0) {}
+
+      private: std::size_t _size;
+    };
+
+  //------------------------------------------------------------
+  // Gives factory functions (and aliases) access to the control block of
+  //   a const_shr<T>.  detach() empties p without dropping its count.
+  //------------------------------------------------------------
+  class shr_access
+  {
+    public: template <typename S, typename C, typename U>
+            static S make(C *ctrl, U *ptr) { return S(ctrl,ptr); }
+
+    public: template <typename S, typename C, typename U>
+            static S make(C *ctrl, U *ptr, std::size_t n) { return S(ctrl,ptr,n); }
+
+    public: template <typename S>
+            static typename S::Ctrl_t *ctrl(const S &p) { return p._ctrl; }
+
+    // A copy of p which takes over a reference already added to its count
+    //   (see shr_copy)
+
+    public: template <typename S>
+            static S share(const S &p)
+            {
+              S rval;
+              static_cast< smrt<typename S::Object_t>& >(rval) = p;
+              rval._ctrl = p._ctrl;
+              return rval;
+            }
+
+    public: template <typename S>
+            static typename S::Ctrl_t *detach(S &p) 
+            { 
+              typename S::Ctrl_t *c = p._ctrl;
+              p._ctrl = NULL;
+              p       = S();
+              return c;
+            }
+  };
+
+  //------------------------------------------------------------
+  // An alias shares the count of another shr, so the two must use the
+  //   same counting policy (see shr_counting<T>)
+  //------------------------------------------------------------
+  template <typename C, typename S>
+    struct shr_alias
+    {
+      static_assert( std::is_same<C, typename S::Ctrl_t>::value, 
+                     "An alias must use the same counting policy as the shr it shares" );
+
+      static C *ctrl(const S &p) { return shr_access::ctrl(p);   }
+      static C *detach(S &p)     { return shr_access::detach(p); }
+    };
+
+
+  template <typename T>
+    class const_shr : public smrt<T>
+    {
+      typedef const_shr<T>  Type_t;
       typedef smrt<T>       Parent_t;
 
-      // Constructors and Assignement
+      friend class shr_access;
+      template <typename U> friend class const_weak_shr;
+
+      public: typedef T                                  Object_t;
+      public: typedef typename shr_counting<T>::Policy_t Policy_t;
+      public: typedef shr_ctrl<Policy_t>                 Ctrl_t;
+
+      // Constructors and Assignment
+
+      public: const_shr(const T *p=NULL) : _ctrl(NULL) { set(p); }
+      public: const_shr(const Type_t &p) : _ctrl(NULL) { set(p); }
+
+      // Moves leave the source NULL and do not touch the reference count
+
+      public: const_shr(Type_t &&p) noexcept : _ctrl(NULL) { take(p); }
+
+      // Takes over the pointer (and deleter) owned by a const_own<T,D> (or own<T,D>)
+
+      public: template <typename D>
+              const_shr(const_own<T,D> &&p) : _ctrl(NULL) { set(p); }
+
+      // Disposes of p with d(p) rather than deleting it
+
+      public: template <typename D>
+              const_shr(const T *p, D d) : _ctrl(NULL) { set(p,d); }
+
+      // Aliases share the count of p, and so keep its object alive, but
+      //   point at ptr (typically a member of that object).  An alias of
+      //   a NULL p is NULL.
+
+      public: template <typename V>
+              const_shr(const const_shr<V> &p, const T *ptr) : _ctrl(NULL) 
+              { 
+                alias( shr_alias< Ctrl_t, const_shr<V> >::ctrl(p), ptr ); 
+              }
+
+      public: template <typename V>
+              const_shr(const_shr<V> &&p, const T *ptr) 
+                : _ctrl( shr_alias< Ctrl_t, const_shr<V> >::detach(p) )
+              { 
+                this->_ptr = ( _ctrl ? ptr : NULL ); 
+              }
+
+      // Upcasts (from a const_shr<U> with U derived from T) share the count
+      //   of p, as aliases of p's object through its T base
+
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type>
+              const_shr(const const_shr<U> &p) : _ctrl(NULL)
+              {
+                alias( shr_alias< Ctrl_t, const_shr<U> >::ctrl(p), p.raw() );
+              }
+
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type>
+              const_shr(const_shr<U> &&p) noexcept : _ctrl(NULL)
+              {
+                const T *ptr = p.raw();
+                _ctrl      = shr_alias< Ctrl_t, const_shr<U> >::detach(p);
+                this->_ptr = ( _ctrl ? ptr : NULL );
+              }
+
+      // Adopts a control block whose count already includes this reference
+
+      protected: const_shr(Ctrl_t *c, const T *p) : _ctrl(c) { this->_ptr = p; }
+
+      public: ~const_shr() { decr(); }
+
+      public: void release(void) { set(NULL); }
+
+      public: Type_t &operator=(const T*  p)       { set(p); return *this; }
+      public: Type_t &operator=(const Type_t &p)   { set(p); return *this; }
+
+      public: template <typename D>
+              Type_t &operator=(const_own<T,D> &&p) { set(p); return *this; }
+
+      public: Type_t &operator=(Type_t &&p) noexcept 
+              { 
+                if(this != &p) { decr(); take(p); }
+                return *this; 
+              }
+
+      // Public Methods
+
+      public: unsigned long refCount(void) const { return ( _ctrl ? _ctrl->value() : 0UL ); }
+
+      // Internal Methods
+
+      protected: void set(const T* p)
+                 {
+                   if(p!=NULL) smrt_stats<T>::adopt();
+                   manage(p);
+                 }
+
+      //------------------------------------------------------------
+      // The new count is taken before the old one is dropped so that
+      //   self-assignment cannot free the object out from under us.
+      //------------------------------------------------------------
+      protected: void set(const const_shr<T> &p)
+                 {
+                   const T *ptr = p._ptr;
+                   Ctrl_t  *c   = p._ctrl;
+                   if( c != NULL ) { c->incr(); smrt_stats<T>::incr(); }
+                   decr();
+                   this->_ptr = ptr;
+                   _ctrl      = c;
+                 }
+
+      protected: template <typename D>
+                 void set(const T *p, const D &d)
+                 {
+                   if(p!=NULL) smrt_stats<T>::adopt();
+                   manage(p,d);
+                 }
+
+      // Ownership passes from a const_own<T,D>, which has already counted
+      //   the object as adopted
+
+      protected: void set(const_own<T> &p)
+                 {
+                   const T *ptr = p._ptr;
+                   p._ptr = NULL;
+                   manage(ptr);
+                 }
+
+      protected: template <typename D>
+                 void set(const_own<T,D> &p)
+                 {
+                   const T *ptr = p._ptr;
+                   p._ptr = NULL;
+                   manage(ptr, p.deleter());
+                 }
+
+      protected: void manage(const T* p)
+                 {
+                   decr();
+                   if(p!=NULL) 
+                   {
+                     try        { _ctrl = new shr_ctrl_ptr<T,Policy_t>(p);  }
+                     catch(...) { smrt_stats<T>::dispose(); delete p; throw; }
+                     smrt_stats<T>::ctrl();
+                   }
+                   this->_ptr = p;
+                 }
+
+      protected: template <typename D>
+                 void manage(const T *p, const D &d)
+                 {
+                   decr();
+                   if(p!=NULL) 
+                   {
+                     try        { _ctrl = new shr_ctrl_del<T,D,Policy_t>(p,d);                       }
+                     catch(...) { smrt_stats<T>::dispose(); D c(d); c( const_cast<T*>(p) ); throw; }
+                     smrt_stats<T>::ctrl();
+                   }
+                   this->_ptr = p;
+                 }
+
+      protected: void alias(Ctrl_t *c, const T *ptr)
+                 {
+                   if( c != NULL ) { c->incr(); smrt_stats<T>::incr(); }
+                   decr();
+                   this->_ptr = ( c ? ptr : NULL );
+                   _ctrl      = c;
+                 }
+
+      protected: void take(Type_t &p) noexcept
+                 {
+                   this->_ptr = p._ptr;
+                   _ctrl      = p._ctrl;
+                   p._ptr     = NULL;
+                   p._ctrl    = NULL;
+                 }
+
+      protected: void decr(void)
+                 {
+                   if( _ctrl != NULL )
+                   {
+                     smrt_stats<T>::decr();
+                     _ctrl->decr();
+                     this->_ptr = NULL; 
+                     _ctrl      = NULL;
+                   }
+                 }
+
+      // Attributes
+
+      protected: Ctrl_t *_ctrl;
+    };
+
+  template <typename T>
+    class shr : public const_shr<T>
+    {
+      typedef       shr<T> Type_t;
+      typedef const_shr<T> Parent_t;
+      typedef      smrt<T> Base_t;
+
+      using Base_t::_ptr;
+      using Base_t::validate;
+
+      // Constructors and Assignment
+
+      friend class shr_access;
+
+      public: shr(T *p=NULL)                : Parent_t(p) {}
+      public: shr(const Type_t &p)          : Parent_t(p) {}
+      public: shr(Type_t &&p) noexcept      : Parent_t(std::move(p)) {}
+
+      public: template <typename D> shr(own<T,D> &&p) : Parent_t(std::move(p)) {}
+      public: template <typename D> shr(T *p, D d)    : Parent_t(p,d) {}
+
+      // Aliases (see const_shr<T> above)
+
+      public: template <typename V> shr(const shr<V> &p, T *ptr) : Parent_t(p,ptr) {}
+      public: template <typename V> shr(shr<V> &&p, T *ptr)      : Parent_t(std::move(p),ptr) {}
+
+      // Upcasts (see const_shr<T> above)
+
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type>
+              shr(const shr<U> &p)     : Parent_t(p) {}
+
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type>
+              shr(shr<U> &&p) noexcept : Parent_t(std::move(p)) {}
+
+      protected: shr(typename Parent_t::Ctrl_t *c, T *p) : Parent_t(c,p) {}
+
+      public: Type_t &operator=(T*  p)           { Parent_t::set(p); return *this; }
+      public: Type_t &operator=(const Type_t &p) { Parent_t::set(p); return *this; }
+
+      public: template <typename D> Type_t &operator=(own<T,D> &&p) { Parent_t::set(p); return *this; }
+
+      public: Type_t &operator=(Type_t &&p) noexcept { Parent_t::operator=(std::move(p)); return *this; }
+
+      // Methods (see notes above in own<T> class)
+
+      public: T &operator*(void)  const { validate(); return *const_cast<T*>(this->_ptr); }
+      public: T *operator->(void) const { validate(); return  const_cast<T*>(this->_ptr); }
+      public: T *raw(void)        const {             return  const_cast<T*>(this->_ptr); }
+    };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Casts between shared pointers
+  //
+  //   Each cast returns a shared pointer which shares the count of p, so the
+  //   object lives until the last of them goes.  The rvalue forms take over
+  //   p's reference and leave p NULL.  A dynamic_shr_cast which fails, or a
+  //   cast of a NULL p, returns NULL and leaves p as it was.  Upcasts need
+  //   no cast at all (shr<Base> b = shr<Derived>(...)).
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename T, typename U>
+    const_shr<T> static_shr_cast(const const_shr<U> &p) { return const_shr<T>( p, static_cast<const T*>(p.raw()) ); }
+
+  template <typename T, typename U>
+    shr<T> static_shr_cast(const shr<U> &p) { return shr<T>( p, static_cast<T*>(p.raw()) ); }
+
+  template <typename T, typename U>
+    const_shr<T> static_shr_cast(const_shr<U> &&p)
+    {
+      const T *ptr = static_cast<const T*>(p.raw());
+      return const_shr<T>( std::move(p), ptr );
+    }
+
+  template <typename T, typename U>
+    shr<T> static_shr_cast(shr<U> &&p)
+    {
+      T *ptr = static_cast<T*>(p.raw());
+      return shr<T>( std::move(p), ptr );
+    }
+
+  template <typename T, typename U>
+    const_shr<T> dynamic_shr_cast(const const_shr<U> &p)
+    {
+      const T *ptr = dynamic_cast<const T*>(p.raw());
+      return ( ptr ? const_shr<T>(p,ptr) : const_shr<T>() );
+    }
+
+  template <typename T, typename U>
+    shr<T> dynamic_shr_cast(const shr<U> &p)
+    {
+      T *ptr = dynamic_cast<T*>(p.raw());
+      return ( ptr ? shr<T>(p,ptr) : shr<T>() );
+    }
+
+  template <typename T, typename U>
+    const_shr<T> dynamic_shr_cast(const_shr<U> &&p)
+    {
+      const T *ptr = dynamic_cast<const T*>(p.raw());
+      return ( ptr ? const_shr<T>(std::move(p),ptr) : const_shr<T>() );
+    }
+
+  template <typename T, typename U>
+    shr<T> dynamic_shr_cast(shr<U> &&p)
+    {
+      T *ptr = dynamic_cast<T*>(p.raw());
+      return ( ptr ? shr<T>(std::move(p),ptr) : shr<T>() );
+    }
+
+  //------------------------------------------------------------
+  // Removes the const from a const_shr<U>.  As with const_cast, writing
+  //   through the result is only safe if the object was not created const.
+  //------------------------------------------------------------
+  template <typename T, typename U>
+    shr<T> const_shr_cast(const const_shr<U> &p)
+    {
+      typedef typename shr<T>::Ctrl_t Ctrl_t;
+
+      Ctrl_t *c = shr_alias< Ctrl_t, const_shr<U> >::ctrl(p);
+      if( c == NULL ) return shr<T>();
+      c->incr();
+      smrt_stats<T>::incr();
+      return shr_access::make< shr<T> >( c, const_cast<T*>(p.raw()) );
+    }
+
+  template <typename T, typename U>
+    shr<T> const_shr_cast(const_shr<U> &&p)
+    {
+      typedef typename shr<T>::Ctrl_t Ctrl_t;
+
+      T      *ptr = const_cast<T*>(p.raw());
+      Ctrl_t *c   = shr_alias< Ctrl_t, const_shr<U> >::detach(p);
+      return shr_access::make< shr<T> >( c, ( c ? ptr : NULL ) );
+    }
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Intrusive shared pointers (option 2 in the README notes on shr<T>)
+  //
+  //   An ishr<T> keeps its reference count inside the T itself, so it is
+  //   the size of a raw pointer and never allocates.  T must either derive
+  //   from ishr_counted<P> or provide these functions (found by ADL):
+  //
+  //     void          ishr_incr(const T *p);   // adds a reference
+  //     bool          ishr_decr(const T *p);   // true if it was the last one
+  //     unsigned long ishr_count(const T *p);  // current count
+  //
+  //   The T is deleted when ishr_decr() returns true.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename P=SMARTPOINTER_ISHR_POLICY>
+    class ishr_counted
+    {
+      typedef ishr_counted<P> Type_t;
+
+      // The count belongs to the object's identity and is never copied
+
+      protected: ishr_counted(void)           : _ishrCount() {}
+      protected: ishr_counted(const Type_t &) : _ishrCount() {}
+      protected: Type_t &operator=(const Type_t &) { return *this; }
+      protected: ~ishr_counted() {}
+
+      public: friend void          ishr_incr(const Type_t *p)  { P::incr(p->_ishrCount);         }
+      public: friend bool          ishr_decr(const Type_t *p)  { return P::decr(p->_ishrCount);  }
+      public: friend unsigned long ishr_count(const Type_t *p) { return P::value(p->_ishrCount); }
+
+      private: mutable typename P::Count_t _ishrCount;
+    };
+
+  template <typename T>
+    class const_ishr : public smrt<T>
+    {
+      typedef const_ishr<T> Type_t;
+      typedef smrt<T>       Parent_t;
+
+      // Constructors and Assignment
+
+      public: const_ishr(const T *p=NULL)         { this->_ptr = NULL; set(p); }
+      public: const_ishr(const Type_t &p)         { this->_ptr = NULL; set(p._ptr); }
+      public: const_ishr(Type_t &&p) noexcept     { this->_ptr = p._ptr; p._ptr = NULL; }
+
+      public: ~const_ishr() { decr(); }
+
+      public: void release(void) { set(NULL); }
+
+      public: Type_t &operator=(const T*  p)     { set(p);      return *this; }
+      public: Type_t &operator=(const Type_t &p) { set(p._ptr); return *this; }
+
+      public: Type_t &operator=(Type_t &&p) noexcept
+              {
+                if(this != &p) { decr(); this->_ptr = p._ptr; p._ptr = NULL; }
+                return *this;
+              }
+
+      // Public Methods
+
+      public: unsigned long refCount(void) const { return ( this->_ptr ? ishr_count(this->_ptr) : 0UL ); }
+
+      // Internal Methods
+
+      // The first reference to an object adopts it
+
+      protected: void set(const T *p)
+                 {
+                   if( p != NULL ) 
+                   {
+                     ishr_incr(p);
+                     if( smrt_tracking<T>::value && ishr_count(p) == 1 ) smrt_stats<T>::adopt();
+                     else                                                 smrt_stats<T>::incr();
+                   }
+                   decr();
+                   this->_ptr = p;
+                 }
+
+      protected: void decr(void)
+                 {
+                   const T *p = this->_ptr;
+                   this->_ptr = NULL;
+                   if( p == NULL ) return;
+                   smrt_stats<T>::decr();
+                   if( ishr_decr(p) ) { smrt_stats<T>::dispose(); smrt_reclaim(p); }
+                 }
+    };
+
+  template <typename T>
+    class ishr : public const_ishr<T>
+    {
+      typedef       ishr<T> Type_t;
+      typedef const_ishr<T> Parent_t;
+      typedef       smrt<T> Base_t;
+
+      using Base_t::validate;
+
+      // Constructors and Assignment
+
+      public: ishr(T *p=NULL)               : Parent_t(p) {}
+      public: ishr(const Type_t &p)         : Parent_t(p) {}
+      public: ishr(Type_t &&p) noexcept     : Parent_t(std::move(p)) {}
+
+      public: Type_t &operator=(T*  p)                { Parent_t::operator=(p);            return *this; }
+      public: Type_t &operator=(const Type_t &p)      { Parent_t::operator=(p);            return *this; }
+      public: Type_t &operator=(Type_t &&p) noexcept  { Parent_t::operator=(std::move(p)); return *this; }
+
+      // Methods (see notes above in own<T> class)
+
+      public: T &operator*(void)  const { validate(); return *const_cast<T*>(this->_ptr); }
+      public: T *operator->(void) const { validate(); return  const_cast<T*>(this->_ptr); }
+      public: T *raw(void)        const {             return  const_cast<T*>(this->_ptr); }
+    };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Compact shared pointers
+  //
+  //   A cshr<T> (or const_cshr<T>) holds nothing but a pointer to its T, so
+  //   it is the size of a raw pointer, half that of a shr<T>.  The T must
+  //   be created by make_cshr<T> (or make_const_cshr<T>), which places it
+  //   in a single block directly behind its reference count.  The count is
+  //   then found at a fixed offset from the T, and dereferencing needs no
+  //   extra arithmetic.  There is no weak_shr<T> for a cshr<T>.
+  //
+  //   As with ishr<T>, the count is embedded, so biased counting is not
+  //   available (see cshr_counting<T>).  A 32-bit count makes the block 
+  //   smaller still for any T aligned to no more than 4 bytes.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  //------------------------------------------------------------
+  // Specialize cshr_counting<T> to select the counting policy of the
+  //   cshr<T> of a single type, e.g.
+  //     template <> struct cshr_counting<Foo> { typedef shr_plain_count32 Policy_t; };
+  //------------------------------------------------------------
+  template <typename T>
+    struct cshr_counting
+    {
+      typedef SMARTPOINTER_ISHR_POLICY Policy_t;
+    };
+
+  template <typename T, typename P>
+    class cshr_block
+    {
+      public: template <typename... Args>
+              cshr_block(Args&&... args) { P::init(_count); new(_obj) T(std::forward<Args>(args)...); }
+
+      public: T *object(void) { return reinterpret_cast<T*>(_obj); }
+
+      // The block holding the T at p
+
+      public: static cshr_block *block(const T *p)
+              {
+                const char *obj = reinterpret_cast<const char*>(p);
+                return reinterpret_cast<cshr_block*>( const_cast<char*>(obj - offsetof(cshr_block, _obj)) );
+              }
+
+      public: void          incr(void)        { P::incr(_count); }
+      public: bool          decr(void)        { return P::decr(_count); }
+      public: unsigned long value(void) const { return P::value(_count); }
+
+      // Destroys the T and frees block b
+
+      public: static void release(void *b)
+              {
+                cshr_block *c = static_cast<cshr_block*>(b);
+                c->object()->~T();
+                delete c;
+              }
+
+      public: static void *operator new(std::size_t n)
+              {
+                return ( shr_pooling<T>::value ? shr_slab<sizeof(cshr_block)>::allocate() : ::operator new(n) );
+              }
+
+      public: static void operator delete(void *p)
+              {
+                if( shr_pooling<T>::value ) shr_slab<sizeof(cshr_block)>::deallocate(p);
+                else                        ::operator delete(p);
+              }
+
+      private: typename P::Count_t            _count;
+      private: alignas(T) unsigned char       _obj[sizeof(T)];
+    };
+
+  template <typename T>
+    class const_cshr : public smrt<T>
+    {
+      typedef const_cshr<T> Type_t;
+      typedef smrt<T>       Parent_t;
+
+      friend class shr_access;
+
+      public: typedef typename cshr_counting<T>::Policy_t Policy_t;
+      public: typedef cshr_block<T,Policy_t>              Block_t;
+
+      // Constructors and Assignment
+
+      public: const_cshr(void)                 { this->_ptr = NULL; }
+      public: const_cshr(const Type_t &p)      { this->_ptr = NULL; set(p._ptr); }
+      public: const_cshr(Type_t &&p) noexcept  { this->_ptr = p._ptr; p._ptr = NULL; }
+
+      // Adopts a block whose count already includes this reference
+
+      protected: const_cshr(Block_t *, const T *p) { this->_ptr = p; }
+
+      public: ~const_cshr() { decr(); }
+
+      public: void release(void) { decr(); }
+
+      public: Type_t &operator=(const Type_t &p) { set(p._ptr); return *this; }
+
+      public: Type_t &operator=(Type_t &&p) noexcept
+              {
+                if(this != &p) { decr(); this->_ptr = p._ptr; p._ptr = NULL; }
+                return *this;
+              }
+
+      // Public Methods
+
+      public: unsigned long refCount(void) const { return ( this->_ptr ? Block_t::block(this->_ptr)->value() : 0UL ); }
+
+      // Internal Methods
+
+      protected: void set(const T *p)
+                 {
+                   if( p != NULL ) { Block_t::block(p)->incr(); smrt_stats<T>::incr(); }
+                   decr();
+                   this->_ptr = p;
+                 }
+
+      protected: void decr(void)
+                 {
+                   const T *p = this->_ptr;
+                   this->_ptr = NULL;
+                   if( p == NULL ) return;
+
+                   Block_t *b = Block_t::block(p);
+                   smrt_stats<T>::decr();
+                   if( b->decr() ) 
+                   { 
+                     smrt_stats<T>::dispose(); 
+                     smrt_reclaiming<T>::Policy_t::reclaim( &Block_t::release, b ); 
+                   }
+                 }
+    };
+
+  template <typename T>
+    class cshr : public const_cshr<T>
+    {
+      typedef       cshr<T> Type_t;
+      typedef const_cshr<T> Parent_t;
+      typedef       smrt<T> Base_t;
+
+      using Base_t::validate;
+
+      // Constructors and Assignment
+
+      friend class shr_access;
+
+      public: cshr(void) {}
+      public: cshr(const Type_t &p)         : Parent_t(p) {}
+      public: cshr(Type_t &&p) noexcept     : Parent_t(std::move(p)) {}
+
+      protected: cshr(typename Parent_t::Block_t *b, T *p) : Parent_t(b,p) {}
+
+      public: Type_t &operator=(const Type_t &p)      { Parent_t::operator=(p);            return *this; }
+      public: Type_t &operator=(Type_t &&p) noexcept  { Parent_t::operator=(std::move(p)); return *this; }
+
+      // Methods (see notes above in own<T> class)
+
+      public: T &operator*(void)  const { validate(); return *const_cast<T*>(this->_ptr); }
+      public: T *operator->(void) const { validate(); return  const_cast<T*>(this->_ptr); }
+      public: T *raw(void)        const {             return  const_cast<T*>(this->_ptr); }
+    };
+
+
+  template <typename T>
+    class const_ref : public smrt<T>
+    {  
+      typedef const_ref<T>  Type_t;
+      typedef smrt<T>       Parent_t;
+
+      // Constructors and Assignement
+
+      public: const_ref(void) {}
+      public: const_ref(const Parent_t &p) { this->_ptr = p.raw(); }
+
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type>
+              const_ref(const smrt<U> &p) { this->_ptr = p.raw(); }
+
+      public: Type_t &operator=( const Parent_t &p )
+              {
+                this->_ptr = p.raw();
+                return *this;
+              }
+
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type>
+              Type_t &operator=( const smrt<U> &p )
+              {
+                this->_ptr = p.raw();
+                return *this;
+              }
+
+      public: void clear(void) { this->_ptr = NULL; }
+    };
+
+  template <typename T>
+    class ref : public const_ref<T>
+    {
+      typedef       ref<T> Type_t;
+      typedef const_ref<T> Parent_t;
+      typedef      smrt<T> Base_t;
+
+      using Base_t::validate;
+
+      // Constructors and Assignment
+
+      //------------------------------------------------------------
+      // A ref<T> may refer to anything held by a non-const owner of a T,
+      //   or of a U derived from T
+      //------------------------------------------------------------
+      public: ref(void) {}
+      public: ref(const ref<T> &p)  : Parent_t(p) {}
+
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type> ref(const shr<U> &p)  : Parent_t(p) {}
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type> ref(const ishr<U> &p) : Parent_t(p) {}
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type> ref(const cshr<U> &p) : Parent_t(p) {}
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type> ref(const ref<U> &p)  : Parent_t(p) {}
+
+      public: template <typename U, typename D, typename = typename smrt_upcast<U,T>::type>
+              ref(const own<U,D> &p) : Parent_t(p) {}
+
+      public: Type_t &operator=(const ref<T> &p)  { Parent_t::operator=(p); return *this; }
+
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type> Type_t &operator=(const shr<U> &p)  { Parent_t::operator=(p); return *this; }
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type> Type_t &operator=(const ishr<U> &p) { Parent_t::operator=(p); return *this; }
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type> Type_t &operator=(const cshr<U> &p) { Parent_t::operator=(p); return *this; }
+      public: template <typename U, typename = typename smrt_upcast<U,T>::type> Type_t &operator=(const ref<U> &p)  { Parent_t::operator=(p); return *this; }
+
+      public: template <typename U, typename D, typename = typename smrt_upcast<U,T>::type>
+              Type_t &operator=(const own<U,D> &p) { Parent_t::operator=(p); return *this; }
+
+      // Methods (see notes above in own<T> class)
+
+      public: T &operator*(void)  const { validate(); return *const_cast<T*>(this->_ptr); }
+      public: T *operator->(void) const { validate(); return  const_cast<T*>(this->_ptr); }
+      public: T *raw(void)        const {             return  const_cast<T*>(this->_ptr); }
+    };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Arrays (own<T[]>, shr<T[]>, const_shr<T[]>, const_ref<T[]>)
+  //
+  //   The array forms hold the element count alongside the pointer and
+  //   dispose of the elements with delete[] (or the given deleter) rather
+  //   than delete.  Elements are reached through operator[], raw(), or
+  //   begin()/end().  None of these is checked, not even for NULL, so that
+  //   loops over the elements compile to plain pointer arithmetic.
+  //
+  //   Arrays may not be converted to or from the single object forms,
+  //   but an alias (see const_shr<T>) may point into an array.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename T>
+    void smrt_delete_array(void *p) { delete[] static_cast<T*>(p); }
+
+  template <typename T>
+    struct smrt_deleter<T[]>
+    {
+      void operator()(const T *p) const
+      {
+        smrt_reclaiming<T>::Policy_t::reclaim( &smrt_delete_array<T>, const_cast<T*>(p) );
+      }
+    };
+
+  //------------------------------------------------------------
+  // Deleter for arrays from make_aligned_own<T> and its siblings (see
+  //   below).  The element count and the start of the allocation are
+  //   kept in a header just ahead of the first element.
+  //------------------------------------------------------------
+  template <typename T>
+    class smrt_aligned_delete
+    {
+      public: struct Header { void *base; std::size_t count; };
+
+      public: static Header *header(const T *p)
+              {
+                return reinterpret_cast<Header*>( const_cast<char*>(reinterpret_cast<const char*>(p)) ) - 1;
+              }
+
+      // Returns uninitialized room for n elements aligned to align bytes
+
+      public: static T *allocate(std::size_t n, std::size_t align)
+              {
+                if( align == 0 || (align & (align-1)) != 0 ) 
+                  throw std::invalid_argument("Array alignment must be a power of two");
+                if( align < alignof(T) )      align = alignof(T);
+                if( align < alignof(Header) ) align = alignof(Header);
+                if( n > (std::size_t(-1) - sizeof(Header) - align) / sizeof(T) ) throw std::bad_alloc();
+
+                void          *base = ::operator new( sizeof(Header) + align - 1 + n*sizeof(T) );
+                std::uintptr_t at   = reinterpret_cast<std::uintptr_t>(base) + sizeof(Header);
+                T             *p    = reinterpret_cast<T*>( (at + align - 1) & ~std::uintptr_t(align - 1) );
+                header(p)->base  = base;
+                header(p)->count = 0;
+                return p;
+              }
+
+      // Destroys the elements (last first) and frees the allocation
+
+      public: void operator()(const T *p) const
+              {
+                Header *h = header(p);
+                for(std::size_t i=h->count; i>0; --i) p[i-1].~T();
+                ::operator delete(h->base);
+              }
+    };
+
+  template <typename T>
+    class smrt<T[]>
+    {
+      typedef smrt<T[]> Type_t;
+
+      // Constructors and Assignment
+      //   True construction must occur in the subclasses
+
+      protected: smrt(void) : _ptr(NULL), _size(0) {}
+
+      // Methods
+
+      public: const T &operator[](std::size_t i) const { return _ptr[i]; }
+      public: const T *raw(void)                 const { return _ptr; }
+      public: const T *begin(void)               const { return _ptr; }
+      public: const T *end(void)                 const { return _ptr + _size; }
+
+      public: std::size_t size(void)  const { return _size; }
+      public: bool        empty(void) const { return _size==0; }
+
+      public: bool isSet(void)     const { return _ptr!=NULL; }
+      public: bool isNull(void)    const { return _ptr==NULL; }
+      public: bool isNotNull(void) const { return _ptr!=NULL; }
+
+      public: bool operator == (const Type_t &p) const { return _ptr == p._ptr; }
+      public: bool operator <  (const Type_t &p) const { return _ptr <  p._ptr; }
+
+      // Attributes
+
+      protected: const T     *_ptr;
+      protected: std::size_t  _size;
+    };
+
+  template <typename T, typename D>
+    class const_own<T[],D> : public smrt<T[]>, private smrt_ebo<D>
+    {
+      typedef const_own<T[],D>  Type_t;
+      typedef smrt<T[]>         Parent_t;
+      typedef smrt_ebo<D>       Deleter_t;
+
+      template <typename U> friend class const_shr;
+
+      // Constructors and Assignment
+
+      public:  const_own(void) : Deleter_t(D()) {}
+      public:  const_own(const T *p, std::size_t n, const D &d=D()) : Deleter_t(d) 
+               { 
+                 this->_ptr  = p; 
+                 this->_size = n; 
+                 if(p != NULL) smrt_stats<T[]>::adopt();
+               }
+      public:  const_own(Type_t &&p) noexcept : Deleter_t(std::move(p.deleter())) { take(p); }
+
+      public: Type_t &operator=(Type_t &&p) noexcept
+              {
+                if(this != &p) { release(); deleter() = std::move(p.deleter()); take(p); }
+                return *this;
+              }
+
+      private: const_own(const Type_t &p);
+      private: Type_t &operator=(const Type_t  &p);
+
+      public: ~const_own() { if(this->_ptr != NULL) dispose(); }
+
+      public: void release(void) { if(this->_ptr != NULL) dispose(); this->_ptr = NULL; this->_size = 0; }
+
+      public: D       &deleter(void)       { return Deleter_t::get(); }
+      public: const D &deleter(void) const { return Deleter_t::get(); }
+
+      // Internal Methods
+
+      private: void dispose(void) { smrt_stats<T[]>::dispose(); deleter()( const_cast<T*>(this->_ptr) ); }
+
+      private: void take(Type_t &p)
+               {
+                 this->_ptr  = p._ptr;
+                 this->_size = p._size;
+                 p._ptr      = NULL;
+                 p._size     = 0;
+               }
+    };
+
+  template <typename T, typename D>
+    class own<T[],D> : public const_own<T[],D>
+    {
+      typedef       own<T[],D> Type_t;
+      typedef const_own<T[],D> Parent_t;
+
+      // Constructors and Assignment
+
+      public:  own(void) {}
+      public:  own(T *p, std::size_t n, const D &d=D()) : Parent_t(p,n,d) {}
+      public:  own(Type_t &&p) noexcept                 : Parent_t(std::move(p)) {}
+
+      public:  Type_t &operator=(Type_t &&p) noexcept { Parent_t::operator=(std::move(p)); return *this; }
+
+      private: own(const Type_t &p);
+      private: Type_t &operator=(const Type_t  &p);
+
+      // Methods (see notes above in own<T> class)
+
+      public:    T &operator[](std::size_t i) const { return const_cast<T*>(this->_ptr)[i]; }
+      public:    T *raw(void)                 const { return const_cast<T*>(this->_ptr); }
+      public:    T *begin(void)               const { return const_cast<T*>(this->_ptr); }
+      public:    T *end(void)                 const { return const_cast<T*>(this->_ptr) + this->_size; }
+    };
+
+  //------------------------------------------------------------
+  // Used by shr<T[]> in place of smrt_deleter<T[]>, as the control block
+  //   has already applied the reclamation policy for T
+  //------------------------------------------------------------
+  template <typename T>
+    struct shr_delete_array
+    {
+      void operator()(T *p) const { delete[] p; }
+    };
+
+  template <typename T>
+    class const_shr<T[]> : public smrt<T[]>
+    {
+      typedef const_shr<T[]>  Type_t;
+      typedef smrt<T[]>       Parent_t;
+
+      friend class shr_access;
+
+      public: typedef T                                    Object_t[];
+      public: typedef typename shr_counting<T[]>::Policy_t Policy_t;
+      public: typedef shr_ctrl<Policy_t>                   Ctrl_t;
+
+      // Constructors and Assignment
+
+      public: const_shr(void)                     : _ctrl(NULL) {}
+      public: const_shr(const T *p, std::size_t n) : _ctrl(NULL) { set(p, n, shr_delete_array<T>()); }
+      public: const_shr(const Type_t &p)          : _ctrl(NULL) { set(p); }
+      public: const_shr(Type_t &&p) noexcept      : _ctrl(NULL) { take(p); }
+
+      public: template <typename D>
+              const_shr(const T *p, std::size_t n, D d) : _ctrl(NULL) { set(p,n,d); }
+
+      public: template <typename D>
+              const_shr(const_own<T[],D> &&p) : _ctrl(NULL) { set(p); }
+
+      // Aliases of n elements from ptr on (see const_shr<T> above)
+
+      public: template <typename V>
+              const_shr(const const_shr<V> &p, const T *ptr, std::size_t n) : _ctrl(NULL) 
+              { 
+                alias( shr_alias< Ctrl_t, const_shr<V> >::ctrl(p), ptr, n ); 
+              }
+
+      public: template <typename V>
+              const_shr(const_shr<V> &&p, const T *ptr, std::size_t n)
+                : _ctrl( shr_alias< Ctrl_t, const_shr<V> >::detach(p) )
+              { 
+                this->_ptr  = ( _ctrl ? ptr : NULL ); 
+                this->_size = ( _ctrl ? n   : 0    );
+              }
+
+      protected: const_shr(Ctrl_t *c, const T *p, std::size_t n) : _ctrl(c) { this->_ptr = p; this->_size = n; }
+
+      public: ~const_shr() { decr(); }
+
+      public: void release(void) { decr(); }
+
+      public: Type_t &operator=(const Type_t &p) { set(p); return *this; }
+
+      public: template <typename D>
+              Type_t &operator=(const_own<T[],D> &&p) { set(p); return *this; }
+
+      public: Type_t &operator=(Type_t &&p) noexcept 
+              { 
+                if(this != &p) { decr(); take(p); }
+                return *this; 
+              }
+
+      // Public Methods
+
+      public: unsigned long refCount(void) const { return ( _ctrl ? _ctrl->value() : 0UL ); }
+
+      // A handle to element i alone, which shares the array's count (see
+      //   the aliases of const_shr<T> above)
+
+      public: const_shr<T> element(std::size_t i) const { return const_shr<T>(*this, this->_ptr + i); }
+
+      // Internal Methods
+
+      protected: void set(const Type_t &p)
+                 {
+                   Ctrl_t *c = p._ctrl;
+                   if( c != NULL ) { c->incr(); smrt_stats<T[]>::incr(); }
+                   decr();
+                   this->_ptr  = p._ptr;
+                   this->_size = p._size;
+                   _ctrl       = c;
+                 }
+
+      protected: template <typename D>
+                 void set(const T *p, std::size_t n, const D &d)
+                 {
+                   if(p!=NULL) smrt_stats<T[]>::adopt();
+                   manage(p,n,d);
+                 }
+
+      // Ownership passes from a const_own<T[],D> (see const_shr<T> above)
+
+      protected: void set(const_own<T[]> &p)
+                 {
+                   const T    *ptr = p._ptr;
+                   std::size_t n   = p._size;
+                   p._ptr  = NULL;
+                   p._size = 0;
+                   manage(ptr, n, shr_delete_array<T>());
+                 }
+
+      protected: template <typename D>
+                 void set(const_own<T[],D> &p)
+                 {
+                   const T    *ptr = p._ptr;
+                   std::size_t n   = p._size;
+                   p._ptr  = NULL;
+                   p._size = 0;
+                   manage(ptr, n, p.deleter());
+                 }
+
+      protected: template <typename D>
+                 void manage(const T *p, std::size_t n, const D &d)
+                 {
+                   decr();
+                   if(p!=NULL) 
+                   {
+                     try        { _ctrl = new shr_ctrl_del<T,D,Policy_t,T[]>(p,d);                     }
+                     catch(...) { smrt_stats<T[]>::dispose(); D c(d); c( const_cast<T*>(p) ); throw; }
+                     smrt_stats<T[]>::ctrl();
+                   }
+                   this->_ptr  = p;
+                   this->_size = ( p ? n : 0 );
+                 }
+
+      protected: void alias(Ctrl_t *c, const T *ptr, std::size_t n)
+                 {
+                   if( c != NULL ) { c->incr(); smrt_stats<T[]>::incr(); }
+                   decr();
+                   this->_ptr  = ( c ? ptr : NULL );
+                   this->_size = ( c ? n   : 0    );
+                   _ctrl       = c;
+                 }
+
+      protected: void take(Type_t &p) noexcept
+                 {
+                   this->_ptr  = p._ptr;
+                   this->_size = p._size;
+                   _ctrl       = p._ctrl;
+                   p._ptr      = NULL;
+                   p._size     = 0;
+                   p._ctrl     = NULL;
+                 }
+
+      protected: void decr(void)
+                 {
+                   if( _ctrl != NULL ) { smrt_stats<T[]>::decr(); _ctrl->decr(); }
+                   this->_ptr  = NULL; 
+                   this->_size = 0;
+                   _ctrl       = NULL;
+                 }
+
+      // Attributes
+
+      protected: Ctrl_t *_ctrl;
+    };
+
+  template <typename T>
+    class shr<T[]> : public const_shr<T[]>
+    {
+      typedef       shr<T[]> Type_t;
+      typedef const_shr<T[]> Parent_t;
+
+      // Constructors and Assignment
+
+      friend class shr_access;
+
+      public: shr(void) {}
+      public: shr(T *p, std::size_t n)      : Parent_t(p,n) {}
+      public: shr(const Type_t &p)          : Parent_t(p) {}
+      public: shr(Type_t &&p) noexcept      : Parent_t(std::move(p)) {}
+
+      public: template <typename D> shr(own<T[],D> &&p)          : Parent_t(std::move(p)) {}
+      public: template <typename D> shr(T *p, std::size_t n, D d) : Parent_t(p,n,d) {}
+
+      public: template <typename V> shr(const shr<V> &p, T *ptr, std::size_t n) : Parent_t(p,ptr,n) {}
+      public: template <typename V> shr(shr<V> &&p, T *ptr, std::size_t n)      : Parent_t(std::move(p),ptr,n) {}
+
+      protected: shr(typename Parent_t::Ctrl_t *c, T *p, std::size_t n) : Parent_t(c,p,n) {}
+
+      public: Type_t &operator=(const Type_t &p) { Parent_t::set(p); return *this; }
+
+      public: template <typename D> Type_t &operator=(own<T[],D> &&p) { Parent_t::set(p); return *this; }
+
+      public: Type_t &operator=(Type_t &&p) noexcept { Parent_t::operator=(std::move(p)); return *this; }
+
+      // Methods (see notes above in own<T> class)
+
+      public: T &operator[](std::size_t i) const { return const_cast<T*>(this->_ptr)[i]; }
+      public: T *raw(void)                 const { return const_cast<T*>(this->_ptr); }
+      public: T *begin(void)               const { return const_cast<T*>(this->_ptr); }
+      public: T *end(void)                 const { return const_cast<T*>(this->_ptr) + this->_size; }
+
+      public: shr<T> element(std::size_t i) const { return shr<T>(*this, raw() + i); }
+    };
+
+  //------------------------------------------------------------
+  // A view of the elements of any array smart pointer, or of a raw array.
+  //   Like const_ref<T>, it does not keep the elements alive.
+  //------------------------------------------------------------
+  template <typename T>
+    class const_ref<T[]> : public smrt<T[]>
+    {  
+      typedef const_ref<T[]>  Type_t;
+      typedef smrt<T[]>       Parent_t;
+
+      // Constructors and Assignement
+
+      public: const_ref(void) {}
+      public: const_ref(const Parent_t &p)          { set(p.raw(), p.size()); }
+      public: const_ref(const T *p, std::size_t n)  { set(p, n); }
+
+      public: Type_t &operator=( const Parent_t &p ) 
+              { 
+                set(p.raw(), p.size());
+                return *this; 
+              }
+
+      public: void clear(void) { set(NULL, 0); }
+
+      // Internal Methods
+
+      protected: void set(const T *p, std::size_t n) { this->_ptr = p; this->_size = n; }
+    };
+
+  template <typename T>
+    class ref<T[]> : public const_ref<T[]>
+    {
+      typedef       ref<T[]> Type_t;
+      typedef const_ref<T[]> Parent_t;
+
+      // Constructors and Assignment
+
+      public: ref(void) {}
+      public: ref(const shr<T[]> &p)         : Parent_t(p) {}
+      public: ref(const ref<T[]> &p)         : Parent_t(p) {}
+      public: ref(T *p, std::size_t n)       : Parent_t(p,n) {}
+
+      public: template <typename D> ref(const own<T[],D> &p) : Parent_t(p) {}
+
+      public: Type_t &operator=(const shr<T[]> &p)  { Parent_t::operator=(p); return *this; }
+      public: Type_t &operator=(const ref<T[]> &p)  { Parent_t::operator=(p); return *this; }
+
+      public: template <typename D> Type_t &operator=(const own<T[],D> &p) { Parent_t::operator=(p); return *this; }
+
+      // Methods (see notes above in own<T> class)
+
+      public: T &operator[](std::size_t i) const { return const_cast<T*>(this->_ptr)[i]; }
+      public: T *raw(void)                 const { return const_cast<T*>(this->_ptr); }
+      public: T *begin(void)               const { return const_cast<T*>(this->_ptr); }
+      public: T *end(void)                 const { return const_cast<T*>(this->_ptr) + this->_size; }
+    };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Weak (non-owning) observers of a shr<T>
+  //
+  //   A weak_shr<T> shares the control block of the shr<T> from which it
+  //   was constructed but does not keep the T alive.  Once the last shr<T> 
+  //   releases the T, the weak_shr<T> reports that it has expired.  Use 
+  //   lock() to obtain a shr<T> (NULL if expired) through which the T can
+  //   be accessed.  With atomic counting, lock() is safe even if another
+  //   thread is releasing the last shr<T> at the same time.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename T>
+    class const_weak_shr
+    {
+      typedef const_weak_shr<T> Type_t;
+
+      public: typedef typename const_shr<T>::Ctrl_t Ctrl_t;
+
+      // Constructors and Assignment
+
+      public: const_weak_shr(void)                  : _ptr(NULL), _ctrl(NULL) {}
+      public: const_weak_shr(const const_shr<T> &p) : _ptr(NULL), _ctrl(NULL) { set(p._ptr, p._ctrl); }
+      public: const_weak_shr(const Type_t &p)       : _ptr(NULL), _ctrl(NULL) { set(p._ptr, p._ctrl); }
+      public: const_weak_shr(Type_t &&p) noexcept   : _ptr(p._ptr), _ctrl(p._ctrl) { p._ptr = NULL; p._ctrl = NULL; }
+
+      public: ~const_weak_shr() { clear(); }
+
+      public: Type_t &operator=(const const_shr<T> &p) { set(p._ptr, p._ctrl); return *this; }
+      public: Type_t &operator=(const Type_t &p)       { set(p._ptr, p._ctrl); return *this; }
+
+      public: Type_t &operator=(Type_t &&p) noexcept
+              {
+                if(this != &p) { clear(); _ptr = p._ptr; _ctrl = p._ctrl; p._ptr = NULL; p._ctrl = NULL; }
+                return *this;
+              }
+
+      // Public Methods
+
+      public: const_shr<T> lock(void) const
+              {
+                if( _ctrl != NULL && _ctrl->lock() ) 
+                {
+                  smrt_stats<T>::incr();
+                  return shr_access::make< const_shr<T> >(_ctrl, _ptr);
+                }
+                return const_shr<T>();
+              }
+
+      public: bool isExpired(void) const { return refCount() == 0; }
+
+      public: unsigned long refCount(void) const { return ( _ctrl ? _ctrl->value() : 0UL ); }
+
+      public: void clear(void) 
+              { 
+                if( _ctrl != NULL ) _ctrl->decrWeak(); 
+                _ptr  = NULL;
+                _ctrl = NULL;
+              }
+
+      // Internal Methods
+
+      protected: void set(const T *p, Ctrl_t *c)
+                 {
+                   if( c != NULL ) c->incrWeak();
+                   clear();
+                   _ptr  = p;
+                   _ctrl = c;
+                 }
+
+      // Attributes
+
+      protected: const T *_ptr;
+      protected: Ctrl_t  *_ctrl;
+    };
+
+  template <typename T>
+    class weak_shr : public const_weak_shr<T>
+    {
+      typedef       weak_shr<T> Type_t;
+      typedef const_weak_shr<T> Parent_t;
+
+      // Constructors and Assignment
+
+      public: weak_shr(void) {}
+      public: weak_shr(const shr<T> &p)          : Parent_t(p) {}
+      public: weak_shr(const Type_t &p)          : Parent_t(p) {}
+      public: weak_shr(Type_t &&p) noexcept      : Parent_t(std::move(p)) {}
+
+      public: Type_t &operator=(const shr<T> &p)      { Parent_t::operator=(p);            return *this; }
+      public: Type_t &operator=(const Type_t &p)      { Parent_t::operator=(p);            return *this; }
+      public: Type_t &operator=(Type_t &&p) noexcept  { Parent_t::operator=(std::move(p)); return *this; }
+
+      // Methods (see notes above in own<T> class)
+
+      public: shr<T> lock(void) const
+              {
+                if( this->_ctrl != NULL && this->_ctrl->lock() ) 
+                {
+                  smrt_stats<T>::incr();
+                  return shr_access::make< shr<T> >(this->_ctrl, const_cast<T*>(this->_ptr));
+                }
+                return shr<T>();
+              }
+    };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Hashing and ordering by address
+  //
+  //   smrt_hash, smrt_equal and smrt_less compare any mix of smart pointers
+  //   and raw pointers by the address they hold.  Each is transparent, so
+  //   a container of smart pointers can be probed with a raw const T*
+  //   without first wrapping it in a temporary owner (which would adopt
+  //   the object and delete it again when the temporary went away).
+  //   std::hash, std::equal_to and std::less are specialized to them below
+  //   for every smart pointer, so the default comparators already behave
+  //   this way.  Ordered containers accept a raw key from C++14, unordered
+  //   containers from C++20.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename T>
+    const void *smrt_address(const smrt<T> &p) { return p.raw(); }
+
+  inline const void *smrt_address(const void *p) { return p; }
+
+  struct smrt_hash
+  {
+    typedef void is_transparent;
+
+    template <typename P>
+      std::size_t operator()(const P &p) const { return std::hash<const void*>()( smrt_address(p) ); }
+  };
+
+  struct smrt_equal
+  {
+    typedef void is_transparent;
+
+    template <typename P, typename Q>
+      bool operator()(const P &a, const Q &b) const { return smrt_address(a) == smrt_address(b); }
+  };
+
+  struct smrt_less
+  {
+    typedef void is_transparent;
+
+    template <typename P, typename Q>
+      bool operator()(const P &a, const Q &b) const { return std::less<const void*>()( smrt_address(a), smrt_address(b) ); }
+  };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Relocation
+  //
+  //   A type is trivially relocatable if moving an object to a new address
+  //   and forgetting the old one can be done by copying its bytes.  The
+  //   smart pointers hold nothing but their pointers (and deleter), and no
+  //   one else records their address, so they all are.  smrt_vector<T> uses
+  //   this to grow with a single realloc, rather than moving each element
+  //   and destroying the original, as std::vector must.
+  //
+  //   Specialize smrt_relocatable<T> for other types which qualify, e.g.
+  //     template <> struct smrt_relocatable<Foo> { static const bool value = true; };
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename T>
+    struct smrt_relocatable
+    {
+      static const bool value = std::is_trivially_copyable<T>::value;
+    };
+
+  template <typename T, typename D> struct smrt_relocatable<       own<T,D> > { static const bool value = smrt_relocatable<D>::value; };
+  template <typename T, typename D> struct smrt_relocatable< const_own<T,D> > { static const bool value = smrt_relocatable<D>::value; };
+
+  template <typename T> struct smrt_relocatable<            shr<T> > { static const bool value = true; };
+  template <typename T> struct smrt_relocatable<      const_shr<T> > { static const bool value = true; };
+  template <typename T> struct smrt_relocatable<           ishr<T> > { static const bool value = true; };
+  template <typename T> struct smrt_relocatable<     const_ishr<T> > { static const bool value = true; };
+  template <typename T> struct smrt_relocatable<           cshr<T> > { static const bool value = true; };
+  template <typename T> struct smrt_relocatable<     const_cshr<T> > { static const bool value = true; };
+  template <typename T> struct smrt_relocatable<            ref<T> > { static const bool value = true; };
+  template <typename T> struct smrt_relocatable<      const_ref<T> > { static const bool value = true; };
+  template <typename T> struct smrt_relocatable<       weak_shr<T> > { static const bool value = true; };
+  template <typename T> struct smrt_relocatable< const_weak_shr<T> > { static const bool value = true; };
+
+  template <typename T, typename A>
+    struct smrt_relocatable< smrt_alloc_delete<T,A> > { static const bool value = smrt_relocatable<A>::value; };
+
+  template <typename T>
+    struct smrt_relocatable< std::allocator<T> > { static const bool value = true; };
+
+  //------------------------------------------------------------
+  // A vector which relocates trivially relocatable elements with realloc
+  //   (and erases them with memmove), and falls back to moving them
+  //   otherwise.  Only the common subset of std::vector is provided.
+  //   Element storage comes from malloc, so T may not be over-aligned.
+  //------------------------------------------------------------
+  template <typename T>
+    class smrt_vector
+    {
+      typedef smrt_vector<T> Type_t;
+
+      static_assert( alignof(T) <= alignof(std::max_align_t), "smrt_vector<T> does not support over-aligned T" );
+
+      public: typedef T           value_type;
+      public: typedef T          *iterator;
+      public: typedef const T    *const_iterator;
+      public: typedef std::size_t size_type;
+
+      public: static const bool Relocatable = smrt_relocatable<T>::value;
+
+      // Constructors and Assignment
+
+      public: smrt_vector(void) : _data(NULL), _size(0), _capacity(0) {}
+
+      public: smrt_vector(const Type_t &v) : _data(NULL), _size(0), _capacity(0)
+              {
+                reserve(v._size);
+                for(size_type i=0; i<v._size; ++i) push_back(v._data[i]);
+              }
+
+      public: smrt_vector(Type_t &&v) noexcept : _data(v._data), _size(v._size), _capacity(v._capacity)
+              {
+                v._data     = NULL;
+                v._size     = 0;
+                v._capacity = 0;
+              }
+
+      public: ~smrt_vector() { clear(); std::free(_data); }
+
+      public: Type_t &operator=(Type_t v) noexcept { swap(v); return *this; }
+
+      // Public Methods
+
+      public: size_type size(void)     const { return _size;     }
+      public: size_type capacity(void) const { return _capacity; }
+      public: bool      empty(void)    const { return _size==0;  }
+
+      public:       T &operator[](size_type i)       { return _data[i]; }
+      public: const T &operator[](size_type i) const { return _data[i]; }
+
+      public:       T &front(void)       { return _data[0]; }
+      public: const T &front(void) const { return _data[0]; }
+      public:       T &back(void)        { return _data[_size-1]; }
+      public: const T &back(void)  const { return _data[_size-1]; }
+
+      public:       T *data(void)        { return _data; }
+      public: const T *data(void)  const { return _data; }
+
+      public:       iterator begin(void)       { return _data; }
+      public: const_iterator begin(void) const { return _data; }
+      public:       iterator end(void)         { return _data + _size; }
+      public: const_iterator end(void)   const { return _data + _size; }
+
+      public: void reserve(size_type n) { if( n > _capacity ) grow(n); }
+
+      public: void push_back(const T &x) { emplace_back(x); }
+      public: void push_back(T &&x)      { emplace_back(std::move(x)); }
+
+      // The new element is built before growing, as args may refer to an
+      //   element which growing would move
+
+      public: template <typename... Args>
+                T &emplace_back(Args&&... args)
+                {
+                  if( _size == _capacity )
+                  {
+                    T x(std::forward<Args>(args)...);
+                    grow( _capacity ? 2*_capacity : 8 );
+                    ::new(static_cast<void*>(_data + _size)) T(std::move(x));
+                  }
+                  else
+                  {
+                    ::new(static_cast<void*>(_data + _size)) T(std::forward<Args>(args)...);
+                  }
+                  return _data[_size++];
+                }
+
+      public: void pop_back(void) { _data[--_size].~T(); }
+
+      public: iterator erase(iterator pos)
+              {
+                if( Relocatable )
+                {
+                  pos->~T();
+                  std::memmove(static_cast<void*>(pos), static_cast<const void*>(pos+1), (end()-pos-1)*sizeof(T));
+                  --_size;
+                }
+                else
+                {
+                  for(iterator i=pos; i+1!=end(); ++i) *i = std::move(*(i+1));
+                  pop_back();
+                }
+                return pos;
+              }
+
+      public: void clear(void)
+              {
+                while( _size ) _data[--_size].~T();
+              }
+
+      public: void swap(Type_t &v) noexcept
+              {
+                std::swap(_data,     v._data);
+                std::swap(_size,     v._size);
+                std::swap(_capacity, v._capacity);
+              }
+
+      // Internal Methods
+
+      private: void grow(size_type n)
+               {
+                 if( n > std::size_t(-1)/sizeof(T) ) throw std::bad_alloc();
+
+                 if( Relocatable )
+                 {
+                   void *p = std::realloc(static_cast<void*>(_data), n*sizeof(T));
+                   if( p == NULL ) throw std::bad_alloc();
+                   _data = static_cast<T*>(p);
+                 }
+                 else
+                 {
+                   T *p = static_cast<T*>( std::malloc(n*sizeof(T)) );
+                   if( p == NULL ) throw std::bad_alloc();
+                   size_type i = 0;
+                   try        { for( ; i<_size; ++i) ::new(static_cast<void*>(p+i)) T(std::move_if_noexcept(_data[i])); }
+                   catch(...) { while( i ) p[--i].~T(); std::free(p); throw; }
+                   for(i=0; i<_size; ++i) _data[i].~T();
+                   std::free(_data);
+                   _data = p;
+                 }
+                 _capacity = n;
+               }
+
+      // Attributes
+
+      private: T         *_data;
+      private: size_type  _size;
+      private: size_type  _capacity;
+    };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Hazard pointers
+  //
+  //   Each thread owns a record holding a single hazard pointer.  A reader
+  //   publishes the pointer it is about to use there (see Guard) and then
+  //   confirms that it is still current.  A writer which unlinks a pointer
+  //   retires it rather than freeing it.  Once a thread has retired
+  //   SMARTPOINTER_HAZARD_SCAN pointers, it frees those which are not
+  //   published by any thread and keeps the rest for its next scan.
+  //
+  //   Records are never freed, but are reused by new threads.  Pointers a
+  //   thread still holds retired when it exits are adopted by the next
+  //   thread to scan.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  struct smrt_hazard_stats
+  {
+    unsigned long records;     // records created (the most threads at once)
+    unsigned long retired;     // pointers retired
+    unsigned long reclaimed;   // retired pointers freed
+    unsigned long pending;     // retired pointers not yet freed
+    unsigned long scans;
+  };
+
+  class smrt_hazard
+  {
+    private: struct Retired
+             {
+               void  *ptr;
+               void (*fn)(void*);
+             };
+
+    private: struct Record
+             {
+               std::atomic<const void*> hazard;
+               std::atomic<bool>        active;
+               Record                  *next;
+               std::vector<Retired>     retired;   // only touched by the active thread
+             };
+
+    private: struct Domain
+             {
+               std::atomic<Record*>       head;
+               std::atomic<unsigned long> records;
+               std::atomic<unsigned long> retired;
+               std::atomic<unsigned long> reclaimed;
+               std::atomic<unsigned long> scans;
+               std::mutex                 lock;       // protects orphans
+               std::vector<Retired>       orphans;    // left by exited threads
+               std::atomic<bool>          orphaned;
+             };
+
+    // The calling thread's record.  Kept as a POD so that it may still be
+    //   used (by way of a temporary record) after the Reaper has run.
+
+    private: enum State { New, Active, Dead };
+
+    private: struct Local
+             {
+               Record *record;
+               State   state;
+             };
+
+    private: struct Reaper
+             {
+               ~Reaper()
+               {
+                 Local &l = local();
+                 scan(l.record);
+                 orphan(l.record);
+                 leave(l.record);
+                 l.record = NULL;
+                 l.state  = Dead;
+               }
+             };
+
+    //------------------------------------------------------------
+    // Publishes a hazard pointer for its lifetime.  Guards must not be
+    //   nested on one thread, as each thread has a single hazard pointer.
+    //------------------------------------------------------------
+    public: class Guard
+            {
+              public: Guard(void) : _temp(false) { _record = enter(_temp); }
+
+              public: ~Guard()
+                      {
+                        _record->hazard.store(NULL, std::memory_order_release);
+                        if( _temp ) leave(_record);
+                      }
+
+              // Returns the current value of src, which remains valid until
+              //   the Guard is destroyed even if src changes meanwhile
+
+              public: template <typename N>
+                      N *protect(const std::atomic<N*> &src)
+                      {
+                        N *p = src.load(std::memory_order_relaxed);
+                        for(;;)
+                        {
+                          _record->hazard.store(p, std::memory_order_seq_cst);
+                          N *q = src.load(std::memory_order_seq_cst);
+                          if( q == p ) return p;
+                          p = q;
+                        }
+                      }
+
+              private: Guard(const Guard &);
+              private: Guard &operator=(const Guard &);
+
+              private: Record *_record;
+              private: bool    _temp;
+            };
+
+    // Public Methods
+
+    // Calls fn(p) once no Guard still protects p
+
+    public: static void retire(void *p, void (*fn)(void*))
+            {
+              bool    temp = false;
+              Record *r    = enter(temp);
+              Retired x    = { p, fn };
+              r->retired.push_back(x);
+              domain().retired.fetch_add(1, std::memory_order_relaxed);
+              if( temp || r->retired.size() >= SMARTPOINTER_HAZARD_SCAN ) scan(r);
+              if( temp ) { orphan(r); leave(r); }
+            }
+
+    // Frees whatever the calling thread has retired that is no longer protected
+
+    public: static void scan(void)
+            {
+              bool    temp = false;
+              Record *r    = enter(temp);
+              scan(r);
+              if( temp ) { orphan(r); leave(r); }
+            }
+
+    public: static smrt_hazard_stats stats(void)
+            {
+              Domain &d = domain();
+              smrt_hazard_stats rval;
+              rval.records   = d.records.load(std::memory_order_relaxed);
+              rval.retired   = d.retired.load(std::memory_order_relaxed);
+              rval.reclaimed = d.reclaimed.load(std::memory_order_relaxed);
+              rval.pending   = rval.retired - rval.reclaimed;
+              rval.scans     = d.scans.load(std::memory_order_relaxed);
+              return rval;
+            }
+
+    // Internal Methods
+
+    private: static Domain &domain(void)
+             {
+               static Domain *d = create();   // never deleted, may outlive static pointers
+               return *d;
+             }
+
+    private: static Domain *create(void)
+             {
+               Domain *d = new Domain;
+               d->head.store(NULL);
+               d->records.store(0);
+               d->retired.store(0);
+               d->reclaimed.store(0);
+               d->scans.store(0);
+               d->orphaned.store(false);
+               return d;
+             }
+
+    private: static Local &local(void)
+             {
+               static thread_local Local l = { NULL, New };
+               return l;
+             }
+
+    // The calling thread's record, or a temporary one (temp=true) which
+    //   must be handed back with leave() once the thread has exited
+
+    private: static Record *enter(bool &temp)
+             {
+               Local &l = local();
+               if( l.record != NULL ) return l.record;
+
+               Record *r = acquire();
+               if( l.state == Dead ) { temp = true; return r; }
+
+               static thread_local Reaper reaper;
+               (void)reaper;
+               l.record = r;
+               l.state  = Active;
+               return r;
+             }
+
+    // Hands whatever an exiting thread still has retired to the next scan
+
+    private: static void orphan(Record *r)
+             {
+               if( r->retired.empty() ) return;
+               Domain &d = domain();
+               std::lock_guard<std::mutex> guard(d.lock);
+               d.orphans.insert(d.orphans.end(), r->retired.begin(), r->retired.end());
+               d.orphaned.store(true, std::memory_order_relaxed);
+               r->retired.clear();
+             }
+
+    private: static void leave(Record *r)
+             {
+               r->hazard.store(NULL, std::memory_order_release);
+               r->active.store(false, std::memory_order_release);
+             }
+
+    private: static Record *acquire(void)
+             {
+               Domain &d = domain();
+               for(Record *r = d.head.load(std::memory_order_acquire); r != NULL; r = r->next)
+               {
+                 bool idle = false;
+                 if( ! r->active.load(std::memory_order_relaxed) &&
+                     r->active.compare_exchange_strong(idle, true, std::memory_order_acquire) ) return r;
+               }
+
+               Record *r = new Record;
+               r->hazard.store(NULL, std::memory_order_relaxed);
+               r->active.store(true, std::memory_order_relaxed);
+               r->next = d.head.load(std::memory_order_relaxed);
+               while( ! d.head.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed) ) {}
+               d.records.fetch_add(1, std::memory_order_relaxed);
+               return r;
+             }
+
+    //------------------------------------------------------------
+    // The retired list is taken over before anything is freed, as freeing
+    //   a pointer may retire others.
+    //------------------------------------------------------------
+    private: static void scan(Record *r)
+             {
+               Domain &d = domain();
+               d.scans.fetch_add(1, std::memory_order_relaxed);
+
+               std::vector<Retired> retired;
+               retired.swap(r->retired);
+               if( d.orphaned.load(std::memory_order_relaxed) )
+               {
+                 std::lock_guard<std::mutex> guard(d.lock);
+                 retired.insert(retired.end(), d.orphans.begin(), d.orphans.end());
+                 d.orphans.clear();
+                 d.orphaned.store(false, std::memory_order_relaxed);
+               }
+
+               std::atomic_thread_fence(std::memory_order_seq_cst);
+               std::vector<const void*> hazards;
+               for(Record *i = d.head.load(std::memory_order_acquire); i != NULL; i = i->next)
+               {
+                 const void *h = i->hazard.load(std::memory_order_acquire);
+                 if( h != NULL ) hazards.push_back(h);
+               }
+
+               unsigned long freed = 0;
+               for(std::size_t i=0; i<retired.size(); ++i)
+               {
+                 bool used = false;
+                 for(std::size_t j=0; j<hazards.size() && !used; ++j) used = ( hazards[j] == retired[i].ptr );
+                 if( used ) { r->retired.push_back(retired[i]); continue; }
+                 retired[i].fn(retired[i].ptr);
+                 freed += 1;
+               }
+               d.reclaimed.fetch_add(freed, std::memory_order_relaxed);
+             }
+  };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // An atomic cell holding a const_shr<T>
+  //
+  //   Any number of threads may load() snapshots of the cell while others
+  //   store() new values, without a lock.  Each value is held in a small
+  //   immutable node.  Readers protect the current node with a hazard
+  //   pointer while they copy its const_shr<T>, and replaced nodes are
+  //   retired to the hazard pointer domain rather than deleted.
+  //
+  //   Snapshots taken by different threads share the T's reference count,
+  //   so T must use a thread safe counting policy (see shr_counting<T>).
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename T>
+    class atomic_shr
+    {
+      typedef atomic_shr<T> Type_t;
+
+      static_assert( const_shr<T>::Policy_t::thread_safe,
+                     "atomic_shr<T> requires a thread safe counting policy for T (see shr_counting<T>)" );
+
+      private: struct Node
+               {
+                 Node(const const_shr<T> &p) : value(p) {}
+                 const const_shr<T> value;
+               };
+
+      // Constructors and Assignment
+
+      public: atomic_shr(void)                  : _node(NULL)    {}
+      public: atomic_shr(const const_shr<T> &p) : _node(make(p)) {}
+
+      public: ~atomic_shr() { retire( _node.load(std::memory_order_relaxed) ); }
+
+      public: Type_t &operator=(const const_shr<T> &p) { store(p); return *this; }
+
+      private: atomic_shr(const Type_t &);
+      private: Type_t &operator=(const Type_t &);
+
+      // Public Methods
+
+      public: const_shr<T> load(void) const
+              {
+                const_shr<T> rval;
+                smrt_hazard::Guard guard;
+                const Node *n = guard.protect(_node);
+                if( n != NULL ) rval = n->value;
+                return rval;
+              }
+
+      public: operator const_shr<T>(void) const { return load(); }
+
+      public: void store(const const_shr<T> &p)
+              {
+                retire( _node.exchange(make(p), std::memory_order_seq_cst) );
+              }
+
+      public: const_shr<T> exchange(const const_shr<T> &p)
+              {
+                Node *old = _node.exchange(make(p), std::memory_order_seq_cst);
+                const_shr<T> rval;
+                if( old != NULL ) rval = old->value;
+                retire(old);
+                return rval;
+              }
+
+      //------------------------------------------------------------
+      // Stores desired if the cell holds the same pointer (sharing the same
+      //   reference count) as expected.  Otherwise expected is set to the
+      //   cell's current value.  Returns true if desired was stored.
+      //------------------------------------------------------------
+      public: bool compareExchange(const_shr<T> &expected, const const_shr<T> &desired)
+              {
+                Node        *d = make(desired);
+                Node        *old;
+                const_shr<T> seen;
+                for(;;)
+                {
+                  {
+                    smrt_hazard::Guard guard;
+                    old = guard.protect(_node);
+                    if( ! same(old, expected) ) { if( old != NULL ) seen = old->value; break; }
+                    if( ! _node.compare_exchange_strong(old, d, std::memory_order_seq_cst) ) continue;
+                  }
+                  retire(old);
+                  return true;
+                }
+                delete d;
+                expected = seen;
+                return false;
+              }
+
+      public: bool isLockFree(void) const { return _node.is_lock_free(); }
+
+      // Internal Methods
+
+      private: static Node *make(const const_shr<T> &p) { return ( p.isNull() ? NULL : new Node(p) ); }
+
+      private: static bool same(const Node *n, const const_shr<T> &p)
+               {
+                 if( n == NULL ) return p.isNull();
+                 return n->value.raw() == p.raw() &&
+                        shr_access::ctrl(n->value) == shr_access::ctrl(p);
+               }
+
+      private: static void drop(void *n) { delete static_cast<Node*>(n); }
+
+      private: static void retire(Node *n) { if( n != NULL ) smrt_hazard::retire(n, &drop); }
+
+      // Attributes
+
+      private: std::atomic<Node*> _node;
+    };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Epoch based reclamation
+  //
+  //   Readers bracket their use of shared objects with an smrt_epoch::Guard
+  //   and may then use plain const_ref<T> (or raw) pointers to any object
+  //   they reach, with no reference counting at all.  Writers unlink an
+  //   object and retire it to the domain instead of deleting it.  It is
+  //   deleted only once every reader which might have seen it has left its
+  //   critical section.
+  //
+  //   The domain keeps a global epoch.  A reader announces the epoch in
+  //   which it entered.  The epoch advances only when every active reader
+  //   has announced the current one, so an object retired in epoch e can
+  //   no longer be reached once the epoch reaches e+2.  A thread tries to
+  //   advance the epoch and frees what it can after every
+  //   SMARTPOINTER_EPOCH_SCAN retirements or on collect().
+  //
+  //   Records are never freed, but are reused by new threads.  Objects a
+  //   thread still holds retired when it exits are adopted by the next
+  //   thread to collect.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  struct smrt_epoch_stats
+  {
+    unsigned long epoch;       // current global epoch
+    unsigned long records;     // records created (the most threads at once)
+    unsigned long retired;     // objects retired
+    unsigned long reclaimed;   // retired objects freed
+    unsigned long pending;     // retired objects not yet freed
+    unsigned long advances;    // times the epoch has advanced
+  };
+
+  class smrt_epoch
+  {
+    private: struct Retired
+             {
+               void           *ptr;
+               void          (*fn)(void*);
+               unsigned long   epoch;
+             };
+
+    private: struct Record
+             {
+               std::atomic<unsigned long> active;    // epoch entered, 0 when outside
+               std::atomic<bool>          inUse;
+               unsigned long              depth;     // nested Guards
+               Record                    *next;
+               std::vector<Retired>       retired;   // only touched by the owning thread
+             };
+
+    private: struct Domain
+             {
+               std::atomic<unsigned long> epoch;
+               std::atomic<Record*>       head;
+               std::atomic<unsigned long> records;
+               std::atomic<unsigned long> retired;
+               std::atomic<unsigned long> reclaimed;
+               std::atomic<unsigned long> advances;
+               std::mutex                 lock;       // protects orphans
+               std::vector<Retired>       orphans;    // left by exited threads
+               std::atomic<bool>          orphaned;
+             };
+
+    // The calling thread's record (see smrt_hazard)
+
+    private: enum State { New, Active, Dead };
+
+    private: struct Local
+             {
+               Record *record;
+               State   state;
+             };
+
+    private: struct Reaper
+             {
+               ~Reaper()
+               {
+                 Local &l = local();
+                 collect(l.record);
+                 orphan(l.record);
+                 leave(l.record);
+                 l.record = NULL;
+                 l.state  = Dead;
+               }
+             };
+
+    //------------------------------------------------------------
+    // A read side critical section.  Guards may be nested; the section
+    //   ends when the outermost Guard is destroyed.
+    //------------------------------------------------------------
+    public: class Guard
+            {
+              public: Guard(void) : _temp(false)
+                      {
+                        _record = enter(_temp);
+                        if( _record->depth++ == 0 ) announce(_record);
+                      }
+
+              public: ~Guard()
+                      {
+                        if( --_record->depth == 0 ) _record->active.store(0, std::memory_order_release);
+                        if( _temp ) leave(_record);
+                      }
+
+              private: Guard(const Guard &);
+              private: Guard &operator=(const Guard &);
+
+              private: Record *_record;
+              private: bool    _temp;
+            };
+
+    // Public Methods
+
+    // Calls fn(p) once no reader which might have seen p remains
+
+    public: static void retire(void *p, void (*fn)(void*))
+            {
+              bool    temp = false;
+              Record *r    = enter(temp);
+              Retired x    = { p, fn, domain().epoch.load(std::memory_order_seq_cst) };
+              r->retired.push_back(x);
+              domain().retired.fetch_add(1, std::memory_order_relaxed);
+              if( temp || r->retired.size() >= SMARTPOINTER_EPOCH_SCAN ) collect(r);
+              if( temp ) { orphan(r); leave(r); }
+            }
+
+    //------------------------------------------------------------
+    // Retires a smart pointer (shr<T>, own<T>, ...) already unlinked from
+    //   any shared structure.  Its reference (or ownership) is dropped
+    //   once the readers have left, e.g.
+    //     smrt_epoch::retire( std::move(old) );
+    //------------------------------------------------------------
+    public: template <typename S>
+            static void retire(S p)
+            {
+              static_assert( ! std::is_pointer<S>::value, "use retire(p,fn) to retire a raw pointer" );
+              S *h = new S( std::move(p) );
+              retire(h, &smrt_delete<S>);
+            }
+
+    // Tries to advance the epoch and frees what the calling thread can
+
+    public: static void collect(void)
+            {
+              bool    temp = false;
+              Record *r    = enter(temp);
+              collect(r);
+              if( temp ) { orphan(r); leave(r); }
+            }
+
+    //------------------------------------------------------------
+    // Waits until everything the calling thread has retired so far has
+    //   been freed.  Must not be called inside a Guard, as it waits for
+    //   all readers (including the caller) to leave.
+    //------------------------------------------------------------
+    public: static void synchronize(void)
+            {
+              bool    temp = false;
+              Record *r    = enter(temp);
+              assert( r->depth == 0 && "smrt_epoch::synchronize() called inside a Guard" );
+              for(;;)
+              {
+                collect(r);
+                if( r->retired.empty() ) break;
+                std::this_thread::yield();
+              }
+              if( temp ) leave(r);
+            }
+
+    public: static smrt_epoch_stats stats(void)
+            {
+              Domain &d = domain();
+              smrt_epoch_stats rval;
+              rval.epoch     = d.epoch.load(std::memory_order_relaxed);
+              rval.records   = d.records.load(std::memory_order_relaxed);
+              rval.retired   = d.retired.load(std::memory_order_relaxed);
+              rval.reclaimed = d.reclaimed.load(std::memory_order_relaxed);
+              rval.pending   = rval.retired - rval.reclaimed;
+              rval.advances  = d.advances.load(std::memory_order_relaxed);
+              return rval;
+            }
+
+    // Internal Methods
+
+    private: static Domain &domain(void)
+             {
+               static Domain *d = create();   // never deleted, may outlive static pointers
+               return *d;
+             }
+
+    private: static Domain *create(void)
+             {
+               Domain *d = new Domain;
+               d->epoch.store(1);
+               d->head.store(NULL);
+               d->records.store(0);
+               d->retired.store(0);
+               d->reclaimed.store(0);
+               d->advances.store(0);
+               d->orphaned.store(false);
+               return d;
+             }
+
+    private: static Local &local(void)
+             {
+               static thread_local Local l = { NULL, New };
+               return l;
+             }
+
+    private: static Record *enter(bool &temp)
+             {
+               Local &l = local();
+               if( l.record != NULL ) return l.record;
+
+               Record *r = acquire();
+               if( l.state == Dead ) { temp = true; return r; }
+
+               static thread_local Reaper reaper;
+               (void)reaper;
+               l.record = r;
+               l.state  = Active;
+               return r;
+             }
+
+    private: static void leave(Record *r)
+             {
+               r->active.store(0, std::memory_order_release);
+               r->inUse.store(false, std::memory_order_release);
+             }
+
+    private: static Record *acquire(void)
+             {
+               Domain &d = domain();
+               for(Record *r = d.head.load(std::memory_order_acquire); r != NULL; r = r->next)
+               {
+                 bool idle = false;
+                 if( ! r->inUse.load(std::memory_order_relaxed) &&
+                     r->inUse.compare_exchange_strong(idle, true, std::memory_order_acquire) ) return r;
+               }
+
+               Record *r = new Record;
+               r->active.store(0, std::memory_order_relaxed);
+               r->inUse.store(true, std::memory_order_relaxed);
+               r->depth = 0;
+               r->next  = d.head.load(std::memory_order_relaxed);
+               while( ! d.head.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed) ) {}
+               d.records.fetch_add(1, std::memory_order_relaxed);
+               return r;
+             }
+
+    //------------------------------------------------------------
+    // The epoch is read again after announcing it, so that it cannot have
+    //   advanced past the announced epoch unseen.
+    //------------------------------------------------------------
+    private: static void announce(Record *r)
+             {
+               Domain &d = domain();
+               unsigned long e = d.epoch.load(std::memory_order_relaxed);
+               for(;;)
+               {
+                 r->active.store(e, std::memory_order_seq_cst);
+                 unsigned long now = d.epoch.load(std::memory_order_seq_cst);
+                 if( now == e ) return;
+                 e = now;
+               }
+             }
+
+    private: static bool advance(void)
+             {
+               Domain &d = domain();
+               std::atomic_thread_fence(std::memory_order_seq_cst);
+               unsigned long e = d.epoch.load(std::memory_order_seq_cst);
+               for(Record *i = d.head.load(std::memory_order_acquire); i != NULL; i = i->next)
+               {
+                 unsigned long a = i->active.load(std::memory_order_seq_cst);
+                 if( a != 0 && a != e ) return false;
+               }
+               if( ! d.epoch.compare_exchange_strong(e, e+1, std::memory_order_seq_cst) ) return false;
+               d.advances.fetch_add(1, std::memory_order_relaxed);
+               return true;
+             }
+
+    private: static void orphan(Record *r)
+             {
+               if( r->retired.empty() ) return;
+               Domain &d = domain();
+               std::lock_guard<std::mutex> guard(d.lock);
+               d.orphans.insert(d.orphans.end(), r->retired.begin(), r->retired.end());
+               d.orphaned.store(true, std::memory_order_relaxed);
+               r->retired.clear();
+             }
+
+    //------------------------------------------------------------
+    // The retired list is taken over before anything is freed, as freeing
+    //   an object may retire others.
+    //------------------------------------------------------------
+    private: static void collect(Record *r)
+             {
+               Domain &d = domain();
+               std::vector<Retired> retired;
+               retired.swap(r->retired);
+               if( d.orphaned.load(std::memory_order_relaxed) )
+               {
+                 std::lock_guard<std::mutex> guard(d.lock);
+                 retired.insert(retired.end(), d.orphans.begin(), d.orphans.end());
+                 d.orphans.clear();
+                 d.orphaned.store(false, std::memory_order_relaxed);
+               }
+
+               advance();
+               unsigned long e = d.epoch.load(std::memory_order_seq_cst);
+
+               unsigned long freed = 0;
+               for(std::size_t i=0; i<retired.size(); ++i)
+               {
+                 if( retired[i].epoch + 2 > e ) { r->retired.push_back(retired[i]); continue; }
+                 retired[i].fn(retired[i].ptr);
+                 freed += 1;
+               }
+               d.reclaimed.fetch_add(freed, std::memory_order_relaxed);
+             }
+  };
+
+  //------------------------------------------------------------
+  // Reclamation policy which retires released objects to the epoch domain,
+  //   so that readers inside a Guard may keep using a const_ref<T> to an
+  //   object whose last shr<T> or own<T> has been released meanwhile.
+  //------------------------------------------------------------
+  struct smrt_reclaim_epoch
+  {
+    static void reclaim(void (*f)(void*), void *x) { smrt_epoch::retire(x,f); }
+  };
+
+  //------------------------------------------------------------
+  // An owning pointer which readers may load concurrently with stores.
+  //   Readers must hold an smrt_epoch::Guard for as long as they use the
+  //   const_ref<T> returned by load().  A replaced T is retired to the
+  //   epoch domain, to be disposed of as an own<T> would (so only the
+  //   default deleter is supported).
+  //------------------------------------------------------------
+  template <typename T>
+    class epoch_own
+    {
+      typedef epoch_own<T> Type_t;
+
+      // Lets load() build a const_ref<T> from a raw pointer
+
+      private: struct View : public smrt<T>
+               {
+                 View(const T *p) { this->_ptr = p; }
+               };
+
+      // Constructors and Assignment
+
+      public: epoch_own(T *p=NULL) : _ptr(p) { if( p != NULL ) smrt_stats<T>::adopt(); }
+      public: epoch_own(own<T> &&p) : _ptr(NULL) { store(std::move(p)); }
+
+      public: template <typename D>
+              epoch_own(own<T,D> &&p) : _ptr(NULL) { store(std::move(p)); }
+
+      public: ~epoch_own() { retire( _ptr.load(std::memory_order_relaxed) ); }
+
+      public: Type_t &operator=(T *p)        { store(p);            return *this; }
+      public: Type_t &operator=(own<T> &&p)  { store(std::move(p)); return *this; }
+
+      public: template <typename D>
+              Type_t &operator=(own<T,D> &&p)  { store(std::move(p)); return *this; }
+
+      private: epoch_own(const Type_t &);
+      private: Type_t &operator=(const Type_t &);
+
+      // Public Methods
+
+      public: const_ref<T> load(void) const { return const_ref<T>( View(_ptr.load(std::memory_order_acquire)) ); }
+
+      public: void store(T *p)
+              {
+                if( p != NULL ) smrt_stats<T>::adopt();
+                retire( _ptr.exchange(p, std::memory_order_acq_rel) );
+              }
+
+      // Ownership passes from an own<T>, which has already counted the
+      //   object as adopted
+
+      public: void store(own<T> &&p)
+              {
+                T *raw = p.raw();
+                p._ptr = NULL;
+                retire( _ptr.exchange(raw, std::memory_order_acq_rel) );
+              }
+
+      public: template <typename D>
+              void store(own<T,D> &&)
+              {
+                static_assert( std::is_same< D, smrt_deleter<T> >::value, "epoch_own<T> only holds objects with the default deleter" );
+              }
+
+      public: void release(void) { store(static_cast<T*>(NULL)); }
+
+      // Internal Methods
+
+      private: static void retire(T *p) { if( p != NULL ) smrt_epoch::retire(p, &Type_t::dispose); }
+
+      // As const_own<T>::dispose(), once the readers have left
+
+      private: static void dispose(void *p)
+               {
+                 smrt_stats<T>::dispose();
+                 smrt_deleter<T>()( static_cast<T*>(p) );
+               }
+
+      // Attributes
+
+      private: std::atomic<T*> _ptr;
+    };
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Cycle collection for shr<T> object graphs
+  //
+  //   A reference count never reaches zero for objects which refer to each
+  //   other in a cycle, so a cycle of shr<T> leaks once the last outside
+  //   reference goes.  Selecting shr_cycle_count for a type (see
+  //   shr_counting<T>) adds synchronous cycle collection by trial deletion
+  //   (Bacon and Rajan, 2001) on top of a plain count:
+  //
+  //     - each decrement which leaves a count above zero buffers that
+  //       object as a possible root of a garbage cycle
+  //     - shr_cycles::collect() takes the buffered roots in batches.  Each
+  //       batch subtracts the counts held by references among the objects
+  //       reachable from its roots.  Those left at zero are referenced only
+  //       from within, and are freed together.
+  //
+  //   The type must list its shr children to the collector:
+  //
+  //     void shrTrace(shr_tracer &t) const { t(_parent)(_left)(_right); }
+  //
+  //   Only objects built by make_shr<T> (or make_const_shr<T> and
+  //   make_recycled_shr<T>) are traced.  Any other object counted by
+  //   shr_cycle_count is a leaf: it is freed along with a cycle which is
+  //   its only referrer, but its own references are never traced.
+  //
+  //   Like shr_plain_count, the count is not thread safe.  Each thread
+  //   buffers the roots it finds and collects only those.  Roots still
+  //   buffered when a thread exits are dropped, not collected.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  struct shr_cycle_count
+  {
+    typedef shr_plain_count WeakPolicy_t;
+
+    static const bool thread_safe = false;
+
+    //------------------------------------------------------------
+    // Black objects are live (or unexamined), Purple ones are buffered as
+    //   possible roots.  Gray, White and Garbage are only seen during a
+    //   collection: being traced, found unreferenced, and being freed.
+    //------------------------------------------------------------
+    enum Color { Black, Purple, Gray, White, Garbage };
+
+    // How to trace and free a block built by make_shr<T> (one per T)
+
+    struct Traced
+    {
+      void      (*trace)(shr_ctrl<shr_cycle_count> *c, shr_tracer &t);
+      void      (*finish)(shr_ctrl<shr_cycle_count> *c);
+      std::size_t size;
+    };
+
+    struct Count_t
+    {
+      unsigned long               count;
+      unsigned char               color;
+      bool                        buffered;   // held in a root buffer
+      shr_ctrl<shr_cycle_count>  *ctrl;       // the block holding this count
+      const Traced               *traced;     // NULL for a leaf
+    };
+
+    static void init(Count_t &c)
+    {
+      c.count    = 1;
+      c.color    = Black;
+      c.buffered = false;
+      c.ctrl     = NULL;
+      c.traced   = NULL;
+    }
+
+    static void bind(Count_t &c, void (*)(void*), void *ctrl) { c.ctrl = static_cast< shr_ctrl<shr_cycle_count>* >(ctrl); }
+
+    static void          incr(Count_t &c)                  { add(c, 1); }
+    static void          add(Count_t &c, unsigned long n)  { c.count += n; if( c.color != Garbage ) c.color = Black; }
+    static bool          decr(Count_t &c)                  { return sub(c, 1); }
+    static unsigned long value(const Count_t &c)           { return c.count; }
+
+    // A garbage object keeps a count while its cycle is freed, but may no
+    //   longer be locked from a weak_shr (see shr_cycles::release)
+
+    static bool incrNonZero(Count_t &c)
+    {
+      if( c.count == 0 || c.color == Garbage ) return false;
+      incr(c);
+      return true;
+    }
+
+    static bool sub(Count_t &c, unsigned long n)
+    {
+      if( (c.count -= n) == 0 ) { c.color = Black; return true; }
+      if( c.color == Black && c.traced != NULL ) buffer(c);
+      return false;
+    }
+
+    static void buffer(Count_t &c);   // see shr_cycles below
+  };
+
+  //------------------------------------------------------------
+  // Passed to T::shrTrace(), which calls it once for each shr (or 
+  //   const_shr) the T holds.  NULL children are ignored.
+  //------------------------------------------------------------
+  class shr_tracer
+  {
+    friend class shr_cycles;
+
+    typedef shr_cycle_count           Policy_t;
+    typedef shr_cycle_count::Count_t  Node_t;
+    typedef shr_ctrl<shr_cycle_count> Ctrl_t;
+
+    public: template <typename U>
+            shr_tracer &operator()(const const_shr<U> &p)
+            {
+              static_assert( std::is_same< typename const_shr<U>::Policy_t, Policy_t >::value,
+                             "A traced shr<T> must be counted by shr_cycle_count (see shr_counting<T>)" );
+              Ctrl_t *c = shr_access::ctrl(p);
+              if( c != NULL ) visit( node(c) );
+              return *this;
+            }
+
+    // What the collector does with each child it is shown
+
+    private: enum Op { MarkGray, Scan, ScanBlack, Collect };
+
+    private: shr_tracer(Op op, std::vector<Node_t*> &stack) : _op(op), _stack(stack) {}
+
+    private: shr_tracer(const shr_tracer &);
+    private: shr_tracer &operator=(const shr_tracer &);
+
+    private: static Node_t &node(Ctrl_t *c) { return c->_count; }
+
+    private: void visit(Node_t &t)
+             {
+               switch( _op )
+               {
+                 case MarkGray:  t.count -= 1; if( t.color != Policy_t::Gray  ) { t.color = Policy_t::Gray;    _stack.push_back(&t); } break;
+                 case Scan:                                                        _stack.push_back(&t);                                 break;
+                 case ScanBlack: t.count += 1; if( t.color != Policy_t::Black ) { t.color = Policy_t::Black;   _stack.push_back(&t); } break;
+                 case Collect:   t.count += 1; if( t.color == Policy_t::White ) { t.color = Policy_t::Garbage; _stack.push_back(&t); } break;
+               }
+             }
+
+    private: Op                    _op;
+    private: std::vector<Node_t*> &_stack;
+  };
+
+  struct shr_cycle_stats
+  {
+    unsigned long roots;          // possible roots now buffered
+    unsigned long collections;    // calls to collect() which found roots
+    unsigned long slices;         // batches of roots examined
+    unsigned long scanned;        // objects traced
+    unsigned long collected;      // objects freed as members of garbage cycles
+    unsigned long bytes;          // bytes of the blocks freed with them
+    unsigned long lastPauseNs;    // duration of the latest collect()
+    unsigned long maxPauseNs;     // longest collect()
+    unsigned long totalPauseNs;   // all collect() calls together
+  };
+
+  class shr_cycles
+  {
+    public: static const std::size_t Batch = 64;   // roots examined at once
+
+    private: typedef shr_cycle_count           Policy_t;
+    private: typedef shr_cycle_count::Count_t  Node_t;
+    private: typedef shr_ctrl<shr_cycle_count> Ctrl_t;
+
+    // One per thread.  The buffered roots each hold a weak reference on
+    //   their block, so that a root freed meanwhile is still readable.
+
+    private: struct State
+             {
+               std::vector<Node_t*> roots;
+               std::vector<Node_t*> batch, stack, garbage;
+               std::size_t          purgeAt;
+               bool                 busy;      // in collect()
+               shr_cycle_stats      stats;
+             };
+
+    private: struct Reaper
+             {
+               ~Reaper()
+               {
+                 State *s = current();
+                 current() = exited();
+                 for(std::size_t i=0; i<s->roots.size(); ++i) drop( *s->roots[i] );
+                 delete s;
+               }
+             };
+
+    // Public Methods
+
+    // Collects every garbage cycle reachable from the buffered roots and
+    //   returns the number of objects freed
+
+    public: static std::size_t collect(void) { return collect( std::chrono::nanoseconds::max() ); }
+
+    //------------------------------------------------------------
+    // Examines batches of roots until none remain or the budget is spent,
+    //   and returns the number of objects freed.  Each batch runs to
+    //   completion, so the pause may exceed the budget by one batch.  Calls
+    //   made while freeing (from a destructor) do nothing.
+    //------------------------------------------------------------
+    public: static std::size_t collect(std::chrono::nanoseconds budget)
+            {
+              State *s = state();
+              if( s == exited() || s->busy || s->roots.empty() ) return 0;
+
+              std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+              std::chrono::nanoseconds              spent(0);
+              std::size_t                           freed = 0;
+
+              s->busy = true;
+              do
+              {
+                freed += slice(*s);
+                spent  = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start );
+              }
+              while( ! s->roots.empty() && spent < budget );
+              s->busy = false;
+
+              unsigned long ns = static_cast<unsigned long>( spent.count() );
+              s->stats.collections  += 1;
+              s->stats.lastPauseNs   = ns;
+              s->stats.totalPauseNs += ns;
+              if( ns > s->stats.maxPauseNs ) s->stats.maxPauseNs = ns;
+              return freed;
+            }
+
+    public: static std::size_t pending(void)
+            {
+              State *s = state();
+              return ( s == exited() ? 0 : s->roots.size() );
+            }
+
+    public: static shr_cycle_stats stats(void)
+            {
+              State *s = state();
+              if( s == exited() ) { shr_cycle_stats none = { 0, 0, 0, 0, 0, 0, 0, 0, 0 }; return none; }
+              shr_cycle_stats rval = s->stats;
+              rval.roots = s->roots.size();
+              return rval;
+            }
+
+    // Makes a block built by make_shr<T> traceable, if T is cycle collected
+
+    public: template <typename T, typename P>
+            static void adopt(shr_ctrl_obj<T,P> *c) { adopt(c, std::is_same<P,Policy_t>()); }
+
+    // Internal Methods
+
+    private: template <typename T, typename P>
+             static void adopt(shr_ctrl_obj<T,P> *, std::false_type) {}
+
+    private: template <typename T, typename P>
+             static void adopt(shr_ctrl_obj<T,P> *c, std::true_type)
+             {
+               static const Policy_t::Traced traced = { &trace< shr_ctrl_obj<T,P> >, &finish< shr_ctrl_obj<T,P> >, sizeof(shr_ctrl_obj<T,P>) };
+               shr_tracer::node(c).traced = &traced;
+             }
+
+    private: template <typename C>
+             static void trace(Ctrl_t *c, shr_tracer &t) { static_cast<C*>(c)->object()->shrTrace(t); }
+
+    // Destroys the object now, whatever the reclamation policy
+
+    private: template <typename C>
+             static void finish(Ctrl_t *c)
+             {
+               C *x = static_cast<C*>(c);
+               x->C::dispose();
+               x->decrWeak();
+             }
+
+    friend struct shr_cycle_count;
+
+    private: static void buffer(Node_t &c)
+             {
+               State *s = state();
+               if( s == exited() ) return;
+               c.color = Policy_t::Purple;
+               if( c.buffered ) return;
+               c.buffered = true;
+               c.ctrl->incrWeak();
+               s->roots.push_back(&c);
+               if( s->roots.size() >= s->purgeAt ) purge(*s);
+             }
+
+    //------------------------------------------------------------
+    // Drops the roots found live (Black) or freed since they were buffered,
+    //   which frees no objects, only the blocks of those already freed
+    //------------------------------------------------------------
+    private: static void purge(State &s)
+             {
+               std::size_t kept = 0;
+               for(std::size_t i=0; i<s.roots.size(); ++i)
+               {
+                 Node_t *r = s.roots[i];
+                 if( r->color == Policy_t::Purple ) s.roots[kept++] = r;
+                 else                               drop(*r);
+               }
+               s.roots.resize(kept);
+               s.purgeAt = std::max<std::size_t>( SMARTPOINTER_CYCLE_ROOTS, 2*kept );
+             }
+
+    private: static void drop(Node_t &r)
+             {
+               r.buffered = false;
+               if( r.color == Policy_t::Purple ) r.color = Policy_t::Black;
+               r.ctrl->decrWeak();
+             }
+
+    //------------------------------------------------------------
+    // One batch: mark the graph reachable from the purple roots gray,
+    //   subtracting each internal reference, then scan it, restoring the
+    //   counts of whatever is still referenced from outside (black) and
+    //   leaving the rest white, then free the white objects.
+    //------------------------------------------------------------
+    private: static std::size_t slice(State &s)
+             {
+               std::size_t n = ( s.roots.size() < Batch ? s.roots.size() : Batch );
+               s.batch.assign(s.roots.end()-n, s.roots.end());
+               s.roots.resize(s.roots.size()-n);
+               s.stats.slices += 1;
+
+               for(std::size_t i=0; i<n; ++i)
+               {
+                 Node_t *r = s.batch[i];
+                 r->buffered = false;
+                 if( r->color == Policy_t::Purple ) markGray(s, *r);
+               }
+               for(std::size_t i=0; i<n; ++i) scan(s, *s.batch[i]);
+               for(std::size_t i=0; i<n; ++i) collectWhite(s, *s.batch[i]);
+
+               std::size_t freed = release(s);
+
+               for(std::size_t i=0; i<n; ++i) s.batch[i]->ctrl->decrWeak();
+               s.batch.clear();
+               return freed;
+             }
+
+    private: static void traceChildren(Node_t &x, shr_tracer &t)
+             {
+               if( x.traced != NULL ) x.traced->trace(x.ctrl, t);
+             }
+
+    private: static void markGray(State &s, Node_t &r)
+             {
+               shr_tracer t(shr_tracer::MarkGray, s.stack);
+               r.color = Policy_t::Gray;
+               s.stack.push_back(&r);
+               while( ! s.stack.empty() )
+               {
+                 Node_t *x = s.stack.back();
+                 s.stack.pop_back();
+                 s.stats.scanned += 1;
+                 traceChildren(*x, t);
+               }
+             }
+
+    private: static void scan(State &s, Node_t &r)
+             {
+               shr_tracer t(shr_tracer::Scan, s.stack);
+               s.stack.push_back(&r);
+               while( ! s.stack.empty() )
+               {
+                 Node_t *x = s.stack.back();
+                 s.stack.pop_back();
+                 if( x->color != Policy_t::Gray ) continue;
+                 if( x->count > 0 ) { scanBlack(*x); continue; }
+                 x->color = Policy_t::White;
+                 traceChildren(*x, t);
+               }
+             }
+
+    // Uses its own stack, as it runs in the middle of scan()
+
+    private: static void scanBlack(Node_t &r)
+             {
+               std::vector<Node_t*> stack;
+               shr_tracer t(shr_tracer::ScanBlack, stack);
+               r.color = Policy_t::Black;
+               stack.push_back(&r);
+               while( ! stack.empty() )
+               {
+                 Node_t *x = stack.back();
+                 stack.pop_back();
+                 traceChildren(*x, t);
+               }
+             }
+
+    //------------------------------------------------------------
+    // Gathers the white objects reachable from r, adding back the count
+    //   of each of their references so that their destructors can drop
+    //   them as usual
+    //------------------------------------------------------------
+    private: static void collectWhite(State &s, Node_t &r)
+             {
+               if( r.color != Policy_t::White ) return;
+               shr_tracer t(shr_tracer::Collect, s.stack);
+               r.color = Policy_t::Garbage;
+               s.stack.push_back(&r);
+               while( ! s.stack.empty() )
+               {
+                 Node_t *x = s.stack.back();
+                 s.stack.pop_back();
+                 s.garbage.push_back(x);
+                 traceChildren(*x, t);
+               }
+             }
+
+    //------------------------------------------------------------
+    // Each garbage object gets one extra reference, so that no count in
+    //   the cycle reaches zero while the destructors drop their references
+    //   to each other.  The extra references are then simply discarded.
+    //   They stay Garbage until then, so a destructor cannot lock a
+    //   weak_shr to another member of the cycle.
+    //------------------------------------------------------------
+    private: static std::size_t release(State &s)
+             {
+               std::vector<Node_t*> &g = s.garbage;
+               for(std::size_t i=0; i<g.size(); ++i) { g[i]->count += 1; g[i]->ctrl->incrWeak(); }
+
+               for(std::size_t i=0; i<g.size(); ++i)
+               {
+                 if( g[i]->traced != NULL ) g[i]->traced->finish(g[i]->ctrl);
+                 else                       g[i]->ctrl->release();
+               }
+
+               std::size_t freed = g.size();
+               for(std::size_t i=0; i<g.size(); ++i)
+               {
+                 Node_t *x = g[i];
+                 if( x->traced != NULL ) s.stats.bytes += x->traced->size;
+                 x->count = 0;
+                 x->color = Policy_t::Black;
+                 x->ctrl->decrWeak();
+               }
+               s.stats.collected += freed;
+               g.clear();
+               return freed;
+             }
+
+    private: static State *&current(void) { static thread_local State *s = NULL; return s; }
+
+    private: static State *exited(void) { static State x; return &x; }
+
+    private: static State *state(void)
+             {
+               State *&s = current();
+               if( s != NULL ) return s;
+               static thread_local Reaper r;
+               (void)r;
+               s = new State();
+               s->purgeAt = SMARTPOINTER_CYCLE_ROOTS;
+               s->busy    = false;
+               return s;
+             }
+  };
+
+  inline void shr_cycle_count::buffer(Count_t &c) { shr_cycles::buffer(c); }
+
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Factories which construct the T and its reference count in a single
+  //   allocation.  The arguments are passed on to T's constructor.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename T, typename... Args>
+    shr<T> make_shr(Args&&... args)
+    {
+      typedef shr_ctrl_obj<T, typename shr<T>::Policy_t> Ctrl_t;
+      Ctrl_t *c = new Ctrl_t(std::forward<Args>(args)...);
+      shr_cycles::adopt(c);
+      smrt_stats<T>::adopt();
+      smrt_stats<T>::ctrl();
+      return shr_access::make< shr<T> >(c, c->object());
+    }
+
+  template <typename T, typename... Args>
+    const_shr<T> make_const_shr(Args&&... args)
+    {
+      typedef shr_ctrl_obj<T, typename const_shr<T>::Policy_t> Ctrl_t;
+      Ctrl_t *c = new Ctrl_t(std::forward<Args>(args)...);
+      shr_cycles::adopt(c);
+      smrt_stats<T>::adopt();
+      smrt_stats<T>::ctrl();
+      return shr_access::make< const_shr<T> >(c, c->object());
+    }
+
+  template <typename T, typename... Args>
+    cshr<T> make_cshr(Args&&... args)
+    {
+      typedef typename cshr<T>::Block_t Block_t;
+      Block_t *b = new Block_t(std::forward<Args>(args)...);
+      smrt_stats<T>::adopt();
+      smrt_stats<T>::ctrl();
+      return shr_access::make< cshr<T> >(b, b->object());
+    }
+
+  template <typename T, typename... Args>
+    const_cshr<T> make_const_cshr(Args&&... args)
+    {
+      return make_cshr<T>(std::forward<Args>(args)...);
+    }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Factories which obtain memory from an allocator rather than the global
+  //   heap.  allocate_shr<T> places the T and its reference count in one
+  //   block from alloc.  allocate_own<T> returns an own<T,D> whose deleter
+  //   hands the T back to (a copy of) alloc; it is the size of a plain
+  //   own<T> whenever the allocator is stateless.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename T, typename A, typename... Args>
+    shr<T> allocate_shr(const A &alloc, Args&&... args)
+    {
+      typedef shr_ctrl_alloc<T, A, typename shr<T>::Policy_t> Ctrl_t;
+      typedef typename Ctrl_t::Alloc_t                        Alloc_t;
+
+      Alloc_t a(alloc);
+      Ctrl_t *c = std::allocator_traits<Alloc_t>::allocate(a, 1);
+      try        { ::new(static_cast<void*>(c)) Ctrl_t(alloc, std::forward<Args>(args)...); }
+      catch(...) { std::allocator_traits<Alloc_t>::deallocate(a, c, 1); throw; }
+      smrt_stats<T>::adopt();
+      smrt_stats<T>::ctrl();
+      return shr_access::make< shr<T> >(c, c->object());
+    }
+
+  template <typename T, typename A, typename... Args>
+    const_shr<T> allocate_const_shr(const A &alloc, Args&&... args)
+    {
+      return allocate_shr<T>(alloc, std::forward<Args>(args)...);
+    }
+
+  template <typename T, typename A, typename... Args>
+    own< T, smrt_alloc_delete<T,A> > allocate_own(const A &alloc, Args&&... args)
+    {
+      typedef smrt_alloc_delete<T,A>       Delete_t;
+      typedef typename Delete_t::Alloc_t   Alloc_t;
+      typedef typename Delete_t::Traits_t  Traits_t;
+
+      Alloc_t a(alloc);
+      T *p = Traits_t::allocate(a, 1);
+      try        { Traits_t::construct(a, p, std::forward<Args>(args)...); }
+      catch(...) { Traits_t::deallocate(a, p, 1); throw; }
+      return own< T, Delete_t >( p, Delete_t(alloc) );
+    }
 
-      public: const_ref(void) {}
-      public: const_ref(const Parent_t &p) { this->_ptr = p.raw(); }
+  ////////////////////////////////////////////////////////////////////////////////
+  // Recycling factories
+  //
+  //   make_recycled_shr<T> builds the T and its count in one block, as
+  //   make_shr<T> does, but the block comes from shr_recycler<T>.  When the
+  //   last reference goes the T is destroyed as usual, but the block is
+  //   kept on a free list for the next make_recycled_shr<T> rather than
+  //   being returned to the heap.
+  //
+  //   Each thread allocates from and frees to its own list without locking.
+  //   A thread which frees more blocks than its limit passes half of them
+  //   to the depot shared by all threads, from which a thread whose list
+  //   is empty takes a batch, so blocks freed by a consumer thread find
+  //   their way back to the producer.  Blocks beyond the depot's limit go
+  //   back to the heap.  trim() empties the calling thread's list and the
+  //   depot; other threads' lists are bounded by their limit.
+  ////////////////////////////////////////////////////////////////////////////////
 
-      public: Type_t &operator=( const Parent_t &p ) 
-              { 
-                this->_ptr = p.raw(); 
-                return *this; 
+  struct shr_recycler_stats
+  {
+    unsigned long hits;       // blocks reused from a free list
+    unsigned long misses;     // blocks allocated from the heap
+    unsigned long recycled;   // blocks put on a free list
+    unsigned long freed;      // blocks returned to the heap (over a limit, or trimmed)
+    unsigned long cached;     // blocks held by the depot and the calling thread
+    unsigned long threadLimit;
+    unsigned long sharedLimit;
+
+    double hitRate(void) const { return ( hits+misses ? double(hits)/(hits+misses) : 0.0 ); }
+  };
+
+  template <typename T>
+    class shr_recycler
+    {
+      private: struct Node { Node *next; };
+
+      // Shared by all threads, protected by its mutex
+
+      private: struct Depot
+               {
+                 std::mutex                lock;
+                 Node                     *free;
+                 std::size_t               count;
+                 std::atomic<std::size_t>  threadLimit;
+                 std::atomic<std::size_t>  sharedLimit;
+                 unsigned long             hits, misses, recycled, freed;
+               };
+
+      // One per thread, used without locking (see shr_slab for the pattern)
+
+      private: enum State { New, Active, Dead };
+
+      private: struct Cache
+               {
+                 Node         *free;
+                 std::size_t   count;
+                 unsigned long hits, misses, recycled, freed;
+                 State         state;
+               };
+
+      private: struct Reaper { ~Reaper() { flush(cache(), cache().count); cache().state = Dead; } };
+
+      // Public Methods
+
+      public: static void *allocate(std::size_t n)
+              {
+                Cache &c = cache();
+                if( c.state != Active && !activate(c) ) return allocateShared(n);
+                if( c.free == NULL ) refill(c);
+                if( c.free == NULL )
+                {
+                  c.misses += 1;
+                  return ::operator new(n);
+                }
+                Node *x = c.free;
+                c.free   = x->next;
+                c.count -= 1;
+                c.hits  += 1;
+                return x;
               }
 
-      public: void clear(void) { this->_ptr = NULL; }
+      public: static void deallocate(void *p)
+              {
+                Cache &c = cache();
+                if( c.state != Active && !activate(c) ) { deallocateShared(p); return; }
+                Node *x = static_cast<Node*>(p);
+                x->next    = c.free;
+                c.free     = x;
+                c.count   += 1;
+                c.recycled += 1;
+
+                std::size_t limit = depot().threadLimit.load(std::memory_order_relaxed);
+                if( c.count > limit ) flush(c, c.count - limit/2);
+              }
+
+      public: static void limit(std::size_t perThread, std::size_t shared)
+              {
+                depot().threadLimit.store(perThread, std::memory_order_relaxed);
+                depot().sharedLimit.store(shared,    std::memory_order_relaxed);
+              }
+
+      public: static void trim(void)
+              {
+                Cache &c = cache();
+                Node  *x = NULL;
+                {
+                  Depot &d = depot();
+                  std::lock_guard<std::mutex> guard(d.lock);
+                  d.freed += c.count + d.count;
+                  x = splice(c.free, d.free);
+                  c.free  = NULL;  c.count = 0;
+                  d.free  = NULL;  d.count = 0;
+                  merge(d,c);
+                }
+                release(x);
+              }
+
+      //------------------------------------------------------------
+      // Counts made by other threads are included once those threads
+      //   next exchange a batch with the depot (or exit).
+      //------------------------------------------------------------
+      public: static shr_recycler_stats stats(void)
+              {
+                Depot &d = depot();
+                Cache &c = cache();
+                std::lock_guard<std::mutex> guard(d.lock);
+                shr_recycler_stats rval;
+                rval.hits        = d.hits     + c.hits;
+                rval.misses      = d.misses   + c.misses;
+                rval.recycled    = d.recycled + c.recycled;
+                rval.freed       = d.freed    + c.freed;
+                rval.cached      = d.count    + c.count;
+                rval.threadLimit = d.threadLimit.load(std::memory_order_relaxed);
+                rval.sharedLimit = d.sharedLimit.load(std::memory_order_relaxed);
+                return rval;
+              }
+
+      // Internal Methods
+
+      private: static Depot &depot(void)
+               {
+                 static Depot *d = create();   // never deleted, may outlive static pointers
+                 return *d;
+               }
+
+      private: static Depot *create(void)
+               {
+                 Depot *d = new Depot();
+                 d->threadLimit.store(SMARTPOINTER_RECYCLE_THREAD);
+                 d->sharedLimit.store(SMARTPOINTER_RECYCLE_SHARED);
+                 return d;
+               }
+
+      private: static Cache &cache(void)
+               {
+                 static thread_local Cache c = { NULL, 0, 0, 0, 0, 0, New };
+                 return c;
+               }
+
+      private: static bool activate(Cache &c)
+               {
+                 if( c.state == Dead ) return false;
+                 static thread_local Reaper r;
+                 (void)r;
+                 c.state = Active;
+                 return true;
+               }
+
+      private: static void refill(Cache &c)
+               {
+                 Depot      &d     = depot();
+                 std::size_t batch = d.threadLimit.load(std::memory_order_relaxed)/2 + 1;
+                 std::lock_guard<std::mutex> guard(d.lock);
+                 for(std::size_t i=0; i<batch && d.free!=NULL; ++i)
+                 {
+                   Node *x = d.free;
+                   d.free   = x->next;
+                   d.count -= 1;
+                   x->next  = c.free;
+                   c.free   = x;
+                   c.count += 1;
+                 }
+                 merge(d,c);
+               }
+
+      // Moves n blocks from c to the depot, and frees those it has no room
+      //   for once the lock is dropped
+
+      private: static void flush(Cache &c, std::size_t n)
+               {
+                 Node *excess = NULL;
+                 {
+                   Depot &d = depot();
+                   std::lock_guard<std::mutex> guard(d.lock);
+                   std::size_t limit = d.sharedLimit.load(std::memory_order_relaxed);
+                   for(std::size_t i=0; i<n && c.free!=NULL; ++i)
+                   {
+                     Node *x = c.free;
+                     c.free   = x->next;
+                     c.count -= 1;
+                     if( d.count < limit ) { x->next = d.free;  d.free = x;  d.count += 1; }
+                     else                  { x->next = excess;  excess = x;  d.freed += 1; }
+                   }
+                   merge(d,c);
+                 }
+                 release(excess);
+               }
+
+      private: static void merge(Depot &d, Cache &c)
+               {
+                 d.hits     += c.hits;      c.hits     = 0;
+                 d.misses   += c.misses;    c.misses   = 0;
+                 d.recycled += c.recycled;  c.recycled = 0;
+                 d.freed    += c.freed;     c.freed    = 0;
+               }
+
+      private: static Node *splice(Node *a, Node *b)
+               {
+                 if( a == NULL ) return b;
+                 Node *x = a;
+                 while( x->next != NULL ) x = x->next;
+                 x->next = b;
+                 return a;
+               }
+
+      private: static void release(Node *x)
+               {
+                 while( x != NULL )
+                 {
+                   Node *next = x->next;
+                   ::operator delete(x);
+                   x = next;
+                 }
+               }
+
+      // Used by threads which have already exited their Reaper
+
+      private: static void *allocateShared(std::size_t n)
+               {
+                 Depot &d = depot();
+                 {
+                   std::lock_guard<std::mutex> guard(d.lock);
+                   if( d.free != NULL )
+                   {
+                     Node *x = d.free;
+                     d.free   = x->next;
+                     d.count -= 1;
+                     d.hits  += 1;
+                     return x;
+                   }
+                   d.misses += 1;
+                 }
+                 return ::operator new(n);
+               }
+
+      private: static void deallocateShared(void *p)
+               {
+                 Depot &d = depot();
+                 {
+                   std::lock_guard<std::mutex> guard(d.lock);
+                   if( d.count < d.sharedLimit.load(std::memory_order_relaxed) )
+                   {
+                     Node *x = static_cast<Node*>(p);
+                     x->next     = d.free;
+                     d.free      = x;
+                     d.count    += 1;
+                     d.recycled += 1;
+                     return;
+                   }
+                   d.freed += 1;
+                 }
+                 ::operator delete(p);
+               }
+    };
+
+  //------------------------------------------------------------
+  // A shr_ctrl_obj whose storage comes from shr_recycler<T>.  The control
+  //   block's destructor is virtual, so the block deletes itself through
+  //   these operators as well.
+  //------------------------------------------------------------
+  template <typename T, typename P>
+    class shr_ctrl_recycled : public shr_ctrl_obj<T,P>
+    {
+      static_assert( alignof(T) <= alignof(std::max_align_t), "make_recycled_shr<T> does not support over-aligned T" );
+
+      public: template <typename... Args>
+              shr_ctrl_recycled(Args&&... args) : shr_ctrl_obj<T,P>(std::forward<Args>(args)...) {}
+
+      public: static void *operator new(std::size_t n) { return shr_recycler<T>::allocate(n); }
+      public: static void  operator delete(void *p)    { shr_recycler<T>::deallocate(p);    }
     };
 
+  template <typename T, typename... Args>
+    shr<T> make_recycled_shr(Args&&... args)
+    {
+      typedef shr_ctrl_recycled<T, typename shr<T>::Policy_t> Ctrl_t;
+      Ctrl_t *c = new Ctrl_t(std::forward<Args>(args)...);
+      shr_cycles::adopt(c);
+      smrt_stats<T>::adopt();
+      smrt_stats<T>::ctrl();
+      return shr_access::make< shr<T> >(c, c->object());
+    }
+
+  template <typename T, typename... Args>
+    const_shr<T> make_recycled_const_shr(Args&&... args)
+    {
+      return make_recycled_shr<T>(std::forward<Args>(args)...);
+    }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Factories for arrays of n value-initialized elements, the first of
+  //   which is aligned to align bytes (a power of two).  The array and its
+  //   header (see smrt_aligned_delete<T>) are a single allocation; for
+  //   the shared forms, the reference count is allocated separately.
+  ////////////////////////////////////////////////////////////////////////////////
+
   template <typename T>
-    class ref : public const_ref<T>
+    own< T[], smrt_aligned_delete<T> > make_aligned_own(std::size_t n, std::size_t align=SMARTPOINTER_ARRAY_ALIGN)
     {
-      typedef       ref<T> Type_t;
-      typedef const_ref<T> Parent_t;
-      typedef      smrt<T> Base_t;
+      typedef smrt_aligned_delete<T> Delete_t;
 
-      using Base_t::validate;
+      T           *p     = Delete_t::allocate(n, align);
+      std::size_t &count = Delete_t::header(p)->count;
+      try        { for( ; count<n; ++count) ::new(static_cast<void*>(p+count)) T(); }
+      catch(...) { Delete_t()(p); throw; }
+      return own< T[], Delete_t >(p, n);
+    }
 
-      // Constructors and Assignment
+  template <typename T>
+    shr<T[]> make_aligned_shr(std::size_t n, std::size_t align=SMARTPOINTER_ARRAY_ALIGN)
+    {
+      return shr<T[]>( make_aligned_own<T>(n, align) );
+    }
 
-      public: ref(void) {}
-      public: ref(const own<T> &p) : Parent_t(p) {}
-      public: ref(const shr<T> &p) : Parent_t(p) {}
-      public: ref(const ref<T> &p) : Parent_t(p) {}
+  template <typename T>
+    const_shr<T[]> make_aligned_const_shr(std::size_t n, std::size_t align=SMARTPOINTER_ARRAY_ALIGN)
+    {
+      return const_shr<T[]>( make_aligned_own<T>(n, align) );
+    }
 
-      public: Type_t &operator=(const own<T> &p) { Parent_t::operator=(p); return *this; }
-      public: Type_t &operator=(const shr<T> &p) { Parent_t::operator=(p); return *this; }
-      public: Type_t &operator=(const ref<T> &p) { Parent_t::operator=(p); return *this; }
+  ////////////////////////////////////////////////////////////////////////////////
+  // Factories for a batch of n objects which live and die together.  The
+  //   count and the elements are one allocation, each element built from
+  //   the same args (or value-initialized).  element(i) hands out a shr<T>
+  //   to a single element which keeps the whole batch alive.
+  ////////////////////////////////////////////////////////////////////////////////
 
-      // Methods (see notes above in own<T> class)
+  template <typename T, typename... Args>
+    shr<T[]> make_shr_block(std::size_t n, const Args&... args)
+    {
+      typedef shr_ctrl_block<T, typename shr<T[]>::Policy_t> Ctrl_t;
+      if( n == 0 ) return shr<T[]>();
+      Ctrl_t *c = Ctrl_t::create(n, args...);
+      smrt_stats<T[]>::adopt();
+      smrt_stats<T[]>::ctrl();
+      return shr_access::make< shr<T[]> >(c, c->object(), n);
+    }
 
-      public: T &operator*(void)  const { validate(); return *const_cast<T*>(this->_ptr); }
-      public: T *operator->(void) const { validate(); return  const_cast<T*>(this->_ptr); }
-      public: T *raw(void)        const {             return  const_cast<T*>(this->_ptr); }
+  template <typename T, typename... Args>
+    const_shr<T[]> make_const_shr_block(std::size_t n, const Args&... args)
+    {
+      return make_shr_block<T>(n, args...);
+    }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Bulk operations on ranges of shr<T> and const_shr<T>
+  //
+  //   Copying or releasing a range one element at a time updates a count
+  //   once per element, even when many elements share the same object.
+  //   These first tally the elements by control block (shr_tally), then
+  //   apply a single add or subtract per distinct block, prefetching the
+  //   blocks a few ahead of the update.  They pay off when a large range
+  //   holds many copies of each of a few pointers with atomic counts,
+  //   where each update is costly.  With plain counts, or with mostly
+  //   distinct pointers, the tally costs more than it saves.
+  //
+  //   shr_copy(first, last, out) : as std::copy (the ranges may not overlap)
+  //   shr_release_all(first, last) : releases every element, leaving it NULL
+  //   shr_clear(c)               : releases every element of c, then clears it
+  ////////////////////////////////////////////////////////////////////////////////
+
+  template <typename C>
+    class shr_tally
+    {
+      public: static const std::size_t Ahead = 8;   // blocks prefetched ahead of the update
+
+      private: struct Entry { C *ctrl; unsigned long count; };
+
+      // An open addressed table, which starts small and doubles whenever
+      //   it becomes half full
+
+      public: shr_tally(void) : _table(64), _shift(58), _distinct(0), _total(0) {}
+
+      public: void add(C *c)
+              {
+                std::size_t mask = _table.size() - 1;
+                std::size_t h    = hash(c);
+                _total += 1;
+                while( _table[h].ctrl != c )
+                {
+                  if( _table[h].ctrl == NULL ) { insert(c, h); return; }
+                  h = (h+1) & mask;
+                }
+                _table[h].count += 1;
+              }
+
+      public: std::size_t   distinct(void) const { return _distinct; }
+      public: unsigned long total(void)    const { return _total; }
+
+      // Calls f(ctrl, count) once for each distinct block
+
+      public: template <typename F>
+              void apply(F f) const
+              {
+                std::size_t n = _table.size();
+                for(std::size_t i=0; i<n; ++i)
+                {
+                  if( i+Ahead < n && _table[i+Ahead].ctrl != NULL ) SMARTPOINTER_PREFETCH(_table[i+Ahead].ctrl);
+                  if( _table[i].ctrl != NULL ) f(_table[i].ctrl, _table[i].count);
+                }
+              }
+
+      private: std::size_t hash(C *c) const
+               {
+                 return std::size_t( (std::uint64_t(reinterpret_cast<std::uintptr_t>(c)) * 0x9E3779B97F4A7C15ULL) >> _shift );
+               }
+
+      // Adds an entry for c at the empty slot h, then rehashes every entry
+      //   into a table twice the size if this one is half full
+
+      private: void insert(C *c, std::size_t h)
+               {
+                 _table[h].ctrl  = c;
+                 _table[h].count = 1;
+                 if( 2*(++_distinct) < _table.size() ) return;
+
+                 std::vector<Entry> old(2*_table.size());
+                 old.swap(_table);
+                 _shift -= 1;
+                 std::size_t mask = _table.size() - 1;
+                 for(std::size_t i=0; i<old.size(); ++i)
+                 {
+                   if( old[i].ctrl == NULL ) continue;
+                   std::size_t j = hash(old[i].ctrl);
+                   while( _table[j].ctrl != NULL ) j = (j+1) & mask;
+                   _table[j] = old[i];
+                 }
+               }
+
+      private: std::vector<Entry> _table;
+      private: unsigned           _shift;
+      private: std::size_t        _distinct;
+      private: unsigned long      _total;
+    };
+
+  //------------------------------------------------------------
+  // All of the references are added before the first element is written.
+  //   Should writing one throw, the references taken for those not yet
+  //   written are dropped again.
+  //------------------------------------------------------------
+  template <typename ForwardIt, typename OutputIt>
+    OutputIt shr_copy(ForwardIt first, ForwardIt last, OutputIt out)
+    {
+      typedef typename std::iterator_traits<ForwardIt>::value_type S;
+      typedef typename S::Ctrl_t                                   Ctrl_t;
+
+      shr_tally<Ctrl_t> tally;
+      for(ForwardIt i=first; i!=last; ++i)
+      {
+        Ctrl_t *c = shr_access::ctrl(*i);
+        if( c != NULL ) tally.add(c);
+      }
+      tally.apply( [](Ctrl_t *c, unsigned long n) { c->add(n); } );
+      smrt_stats<typename S::Object_t>::incr( tally.total() );
+
+      ForwardIt i = first;
+      try
+      {
+        for( ; i!=last; ++i, ++out) *out = shr_access::share(*i);
+      }
+      catch(...)
+      {
+        for(++i; i!=last; ++i)
+        {
+          Ctrl_t *c = shr_access::ctrl(*i);
+          if( c != NULL ) { smrt_stats<typename S::Object_t>::decr(); c->decr(); }
+        }
+        throw;
+      }
+      return out;
+    }
+
+  //------------------------------------------------------------
+  // The objects whose last references are released here are destroyed
+  //   in an unspecified order (the order in which the tally visits their
+  //   blocks, which is by hash), not in the order of the range
+  //------------------------------------------------------------
+  template <typename ForwardIt>
+    void shr_release_all(ForwardIt first, ForwardIt last)
+    {
+      typedef typename std::iterator_traits<ForwardIt>::value_type S;
+      typedef typename S::Ctrl_t                                   Ctrl_t;
+
+      shr_tally<Ctrl_t> tally;
+      for(ForwardIt i=first; i!=last; ++i)
+      {
+        Ctrl_t *c = shr_access::detach(*i);
+        if( c != NULL ) tally.add(c);
+      }
+      smrt_stats<typename S::Object_t>::decr( tally.total() );
+      tally.apply( [](Ctrl_t *c, unsigned long n) { c->sub(n); } );
+    }
+
+  template <typename Container>
+    void shr_clear(Container &c)
+    {
+      shr_release_all(c.begin(), c.end());
+      c.clear();
+    }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Serialization of object graphs held by shr<T> and own<T>
+  //
+  //   smrt_writer w(fd) : writes to the file descriptor fd through a buffer
+  //                       of SMARTPOINTER_IO_BUFFER bytes
+  //   w.put(p)          : writes a shr<T>, const_shr<T>, own<T> or const_own<T>,
+  //                       followed by every object reachable from it
+  //   w.put(x)          : writes a trivially copyable x (not a raw pointer),
+  //                       or a std::string
+  //   w.flush()         : writes out the buffer (~smrt_writer also does, but
+  //                       cannot report a failure)
+  //
+  //   smrt_reader r(fd) : reads from fd what a smrt_writer wrote
+  //   r.get(p)          : reads a shr<T>, const_shr<T> or own<T>
+  //   r.get(x)          : reads a trivially copyable x (not a raw pointer),
+  //                       or a std::string
+  //
+  //   A T is written by a member void smrtWrite(smrt_writer&) const, and
+  //   read into a default constructed T by void smrtRead(smrt_reader&),
+  //   which must get() exactly what smrtWrite put(), in the same order.
+  //
+  //   An object held by more than one shr is written once, when it is
+  //   first met, and each later shr to it as a back reference to it.  When
+  //   read, the back references become copies of the first shr, and so
+  //   share its count, and cycles are restored along with everything else.
+  //   An object whose count is 1 cannot be met twice, so it is not
+  //   remembered, nor is the object of an own<T>.  Objects are identified
+  //   by address and type, so the graph must not change while it is
+  //   written, and an alias (see const_shr) is written as an object of its
+  //   own.
+  //
+  //   A pointer to a polymorphic T is followed by the dynamic type of its
+  //   object, which is identified by its full address and that type, so
+  //   an object reached through both a shr<Derived> and a shr<Base> is
+  //   written once and read back shared.  Each class other than T whose
+  //   objects are reached through a T* must be declared on both sides,
+  //   along with each of its bases it is reached through, with
+  //   smrt_serial::registerType<Derived, Bases...>(), or the writer throws
+  //   std::logic_error.  Such an object is made and read as a Derived, and
+  //   must be counted with the same policy as T.  An object of a class
+  //   with no virtual functions is identified by its static type, and so
+  //   must always be written through pointers to the same type.
+  //
+  //   The content of an object is not written in place of its pointer,
+  //   but after the content of the object being written (breadth first),
+  //   so that neither long chains nor cycles recurse.  Beyond the buffers,
+  //   the memory used is an entry per shared object and the queue of the
+  //   objects met whose content is still to come.  The reader holds a
+  //   reference to each shared object until it is destroyed, and reads
+  //   the content of an object after get() has set the pointer to it, so
+  //   that pointer must be left alone until the outermost get() returns.
+  //
+  //   Values are written in the byte order and layout of the machine, for
+  //   reading back by the same build.
+  ////////////////////////////////////////////////////////////////////////////////
+
+  struct smrt_serial_stats
+  {
+    unsigned long objects;    // objects written (or read)
+    unsigned long shared;     // of which may be referred to again
+    unsigned long backrefs;   // references to those written (or read)
+    unsigned long bytes;      // bytes passed to (or taken from) the file descriptor
+  };
+
+  class smrt_writer;
+  class smrt_reader;
+
+  struct smrt_serial
+  {
+    // Each pointer is written as a tag, which for a back reference is Ref
+    //   plus the number of the shared object (counting from 0)
+
+    enum Tag { Null = 0, Unique = 1, Shared = 2, Ref = 3 };
+
+    enum { Magic = 0x54524d53, Version = 1 };   // "SMRT"
+
+    // What put(x) and get(x) write as bytes, and the pointers they refuse
+
+    template <typename T>
+      struct isAddress : std::integral_constant< bool, std::is_pointer<T>::value || std::is_member_pointer<T>::value > {};
+
+    template <typename T>
+      struct isValue : std::integral_constant< bool, std::is_trivially_copyable<T>::value && ! isAddress<T>::value > {};
+
+    // Turns a pointer to a D into a pointer to one of its bases
+
+    typedef void *(*Upcast_t)(void*);
+
+    struct Base_t
+    {
+      const std::type_info  *type;
+      Upcast_t               upcast;
+    };
+
+    // A class registered to be reached through pointers to its bases
+
+    struct Type_t
+    {
+      const std::type_info  *type;
+      const std::type_info  *ctrl;                          // of a shr<D>
+      void                 (*write)(const void*, smrt_writer&);
+      void                 (*read)(void*, smrt_reader&);
+      void                *(*makeShr)(void**);              // sets the control block, holding one reference
+      void                *(*makeOwn)(void);
+      void                 (*dispose)(void*);               // deletes what makeOwn made
+      void                 (*drop)(void*);                  // drops a reference from the control block
+      std::vector<Base_t>    bases;
     };
 
+    //------------------------------------------------------------
+    // Registers D, to be reached through pointers to each of Bases.
+    //   Registering D again adds the bases not already known.
+    //------------------------------------------------------------
+    template <typename D, typename... Bases>
+      static void registerType(void)
+      {
+        static_assert( std::is_default_constructible<D>::value, "smrt_serial::registerType<D> requires a default constructible D" );
+
+        Type_t t = { &typeid(D), &typeid(typename shr<D>::Ctrl_t), &writeObject<D>, &readObject<D>, 
+                     &makeShr<D>, &makeOwn<D>, &dispose<D>, &drop<D>, { base<D,Bases>()... } };
+        std::lock_guard<std::mutex> guard( lock() );
+        std::pair<std::unordered_map<std::string, Type_t>::iterator, bool> i = types().insert( std::make_pair( std::string(typeid(D).name()), t ) );
+        if( i.second ) return;
+
+        std::vector<Base_t> &known = i.first->second.bases;
+        for(std::size_t j=0; j<t.bases.size(); ++j)
+        {
+          std::size_t k = 0;
+          while( k < known.size() && *known[k].type != *t.bases[j].type ) ++k;
+          if( k == known.size() ) known.push_back( t.bases[j] );
+        }
+      }
+
+    static const Type_t *find(const std::string &name)
+    {
+      std::lock_guard<std::mutex> guard( lock() );
+      std::unordered_map<std::string, Type_t>::const_iterator i = types().find(name);
+      return ( i != types().end() ? &i->second : NULL );
+    }
+
+    // How to reach base b from an object of type d, or NULL if d was not
+    //   registered with b among its bases
+
+    static Upcast_t findBase(const std::type_info &d, const std::type_info &b)
+    {
+      std::lock_guard<std::mutex> guard( lock() );
+      std::unordered_map<std::string, Type_t>::const_iterator i = types().find( d.name() );
+      if( i == types().end() ) return NULL;
+      const std::vector<Base_t> &bases = i->second.bases;
+      for(std::size_t k=0; k<bases.size(); ++k) if( *bases[k].type == b ) return bases[k].upcast;
+      return NULL;
+    }
+
+    // The address and type which identify the object p points to
+
+    template <typename T>
+      static std::pair<const void*, std::type_index> identity(const T *p, std::false_type)
+      {
+        return std::make_pair( static_cast<const void*>(p), std::type_index(typeid(T)) );
+      }
+
+    template <typename T>
+      static std::pair<const void*, std::type_index> identity(const T *p, std::true_type)
+      {
+        return std::make_pair( dynamic_cast<const void*>(p), std::type_index(typeid(*p)) );
+      }
+
+    // Each taking a pointer to an object of exactly type D
+
+    template <typename D> static void  writeObject(const void *x, smrt_writer &w) { static_cast<const D*>(x)->smrtWrite(w); }
+    template <typename D> static void  readObject(void *x, smrt_reader &r)        { static_cast<D*>(x)->smrtRead(r); }
+    template <typename D> static void *makeOwn(void)                              { return new D(); }
+    template <typename D> static void  dispose(void *x)                           { delete static_cast<D*>(x); }
+
+    template <typename D, typename B>
+      static void *upcast(void *x) { return static_cast<B*>( static_cast<D*>(x) ); }
+
+    template <typename D, typename B>
+      static Base_t base(void)
+      {
+        static_assert( std::is_base_of<B,D>::value, "smrt_serial::registerType<D, Bases...> requires each of Bases to be a base of D" );
+        Base_t b = { &typeid(B), &upcast<D,B> };
+        return b;
+      }
+
+    template <typename D>
+      static void *makeShr(void **c)
+      {
+        shr<D> p = make_shr<D>();
+        D     *x = p.raw();
+        *c = shr_access::detach(p);
+        return x;
+      }
+
+    template <typename D>
+      static void drop(void *c)
+      {
+        smrt_stats<D>::decr();
+        static_cast<typename shr<D>::Ctrl_t*>(c)->decr();
+      }
+
+    [[noreturn]] SMARTPOINTER_COLD static void fail(const char *who)
+    {
+      throw std::runtime_error( std::string(who) + ": " + std::strerror(errno) );
+    }
+
+    [[noreturn]] SMARTPOINTER_COLD static void corrupt(const std::string &what)
+    {
+      throw std::runtime_error( "smrt_reader: " + what );
+    }
+
+    private: static std::mutex &lock(void) { static std::mutex m; return m; }
+
+    private: static std::unordered_map<std::string, Type_t> &types(void)
+             {
+               static std::unordered_map<std::string, Type_t> t;
+               return t;
+             }
+  };
+
+  class smrt_writer
+  {
+    private: typedef void (*Write_t)(const void*, smrt_writer&);
+    private: typedef std::pair<const void*, Write_t> Pending_t;
+    private: typedef std::pair<const void*, std::type_index> Key_t;
+    private: typedef std::pair<unsigned long, const smrt_serial::Type_t*> Known_t;
+    private: typedef std::unordered_map<std::type_index, Known_t> Types_t;
+
+    private: struct Hash_t
+             {
+               std::size_t operator()(const Key_t &k) const { return std::hash<const void*>()(k.first) ^ k.second.hash_code(); }
+             };
+
+    private: typedef std::unordered_map<Key_t, unsigned long, Hash_t> Ids_t;
+
+    public: explicit smrt_writer(int fd, std::size_t size=SMARTPOINTER_IO_BUFFER)
+              : _fd(fd), _buf( size > 16 ? size : 16 ), _used(0), _draining(false), _stats()
+            {
+              putVarint(smrt_serial::Magic);
+              putVarint(smrt_serial::Version);
+            }
+
+    public: ~smrt_writer() { try { flush(); } catch(...) {} }
+
+    private: smrt_writer(const smrt_writer&);
+    private: smrt_writer &operator=(const smrt_writer&);
+
+    // Pointers
+
+    public: template <typename T>
+            smrt_writer &put(const const_shr<T> &p)
+            {
+              const T *x = p.raw();
+              if( x == NULL )         return putVarint(smrt_serial::Null);
+              if( p.refCount() == 1 ) { putVarint(smrt_serial::Unique); return object(x); }
+
+              Key_t key = smrt_serial::identity( x, std::is_polymorphic<T>() );
+              typename Ids_t::iterator i = _ids.find(key);
+              if( i != _ids.end() ) { _stats.backrefs += 1; return putVarint(smrt_serial::Ref + i->second); }
+
+              unsigned long id = _ids.size();
+              _ids.insert( std::make_pair(key, id) );
+              _stats.shared += 1;
+              putVarint(smrt_serial::Shared);
+              return object(x);
+            }
+
+    public: template <typename T, typename D>
+            smrt_writer &put(const const_own<T,D> &p)
+            {
+              if( p.raw() == NULL ) return putVarint(smrt_serial::Null);
+              putVarint(smrt_serial::Unique);
+              return object( p.raw() );
+            }
+
+    // Values.  A raw pointer is trivially copyable, but only its address
+    //   would be written, which means nothing when read back.
+
+    public: template <typename T, typename = typename std::enable_if< smrt_serial::isValue<T>::value >::type>
+            smrt_writer &put(const T &x) { return write( &x, sizeof(T) ); }
+
+    public: template <typename T, typename = typename std::enable_if< smrt_serial::isAddress<T>::value >::type, typename = void>
+            smrt_writer &put(const T &)
+            {
+              static_assert( sizeof(T) == 0, "smrt_writer::put: a raw pointer cannot be written, hold its object in a shr<T> or own<T>" );
+              return *this;
+            }
+
+    public: smrt_writer &put(const std::string &s)
+            {
+              putVarint( s.size() );
+              return write( s.data(), s.size() );
+            }
+
+    public: smrt_writer &putVarint(unsigned long long v)
+            {
+              unsigned char b[10];
+              std::size_t   n = 0;
+              do { b[n] = (unsigned char)( v & 0x7f ); v >>= 7; b[n++] |= ( v ? 0x80 : 0 ); } while( v );
+              return write(b, n);
+            }
+
+    // Blocks as large as the buffer bypass it
+
+    public: smrt_writer &write(const void *p, std::size_t n)
+            {
+              const char *s = static_cast<const char*>(p);
+              if( _used + n > _buf.size() ) flush();
+              if( n >= _buf.size() ) { sink(s, n); return *this; }
+              std::memcpy( _buf.data() + _used, s, n );
+              _used += n;
+              return *this;
+            }
+
+    public: void flush(void)
+            {
+              std::size_t n = _used;
+              _used = 0;
+              sink( _buf.data(), n );
+            }
+
+    public: const smrt_serial_stats &stats(void) const { return _stats; }
+
+    // Internal Methods
+
+    private: template <typename T>
+             smrt_writer &object(const T *x) { return object( x, std::is_polymorphic<T>() ); }
+
+    private: template <typename T>
+             smrt_writer &object(const T *x, std::false_type) { return queue( x, &smrt_serial::writeObject<T> ); }
+
+    // A polymorphic object is preceded by its type: 0 for T itself, else
+    //   the number of the type in this stream, and the first time the type
+    //   appears, its name
+
+    private: template <typename T>
+             smrt_writer &object(const T *x, std::true_type)
+             {
+               const std::type_info &t = typeid(*x);
+               if( t == typeid(T) ) { putVarint(0); return queue( x, &smrt_serial::writeObject<T> ); }
+
+               Types_t::iterator i = _types.find( std::type_index(t) );
+               if( i != _types.end() ) putVarint( i->second.first );
+               else
+               {
+                 const smrt_serial::Type_t *d = smrt_serial::find( t.name() );
+                 if( d == NULL ) 
+                   throw std::logic_error( "smrt_writer: " + smrt_stats_registry::name(t.name()) + " is not registered (see smrt_serial::registerType)" );
+                 i = _types.insert( std::make_pair( std::type_index(t), Known_t(_types.size()+1, d) ) ).first;
+                 putVarint( i->second.first );
+                 put( std::string(t.name()) );
+               }
+               return queue( dynamic_cast<const void*>(x), i->second.second->write );
+             }
+
+    private: smrt_writer &queue(const void *x, Write_t write)
+             {
+               _stats.objects += 1;
+               _pending.push_back( Pending_t(x, write) );
+               if( ! _draining ) drain();
+               return *this;
+             }
+
+    private: void drain(void)
+             {
+               _draining = true;
+               try
+               {
+                 while( ! _pending.empty() )
+                 {
+                   Pending_t p = _pending.front();
+                   _pending.pop_front();
+                   p.second(p.first, *this);
+                 }
+               }
+               catch(...) { _pending.clear(); _draining = false; throw; }
+               _draining = false;
+             }
+
+    private: void sink(const char *p, std::size_t n)
+             {
+               _stats.bytes += n;
+               while( n > 0 )
+               {
+                 long k = long( ::write(_fd, p, n) );
+                 if( k < 0 && errno == EINTR ) continue;
+                 if( k <= 0 ) smrt_serial::fail("smrt_writer");
+                 p += k;
+                 n -= std::size_t(k);
+               }
+             }
+
+    // Attributes
+
+    private: int                   _fd;
+    private: std::vector<char>     _buf;
+    private: std::size_t           _used;
+    private: bool                  _draining;
+    private: std::deque<Pending_t> _pending;
+    private: Ids_t                 _ids;
+    private: Types_t               _types;
+    private: smrt_serial_stats     _stats;
+  };
+
+  class smrt_reader
+  {
+    private: typedef void (*Read_t)(void*, smrt_reader&);
+    private: typedef std::pair<void*, Read_t> Pending_t;
+
+    private: typedef std::vector<const smrt_serial::Type_t*> Types_t;
+
+    // An object read, and a reference held to it (while it is being made,
+    //   or for good if it is shared).  ptr is to the object's own type.
+
+    private: struct Entry_t
+             {
+               void                  *ctrl;
+               void                  *ptr;
+               const std::type_info  *type;
+               const std::type_info  *counter;
+               void                 (*drop)(void*);
+             };
+
+    public: explicit smrt_reader(int fd, std::size_t size=SMARTPOINTER_IO_BUFFER)
+              : _fd(fd), _buf( size > 16 ? size : 16 ), _pos(0), _end(0), _draining(false), _stats()
+            {
+              if( getVarint() != smrt_serial::Magic )   smrt_serial::corrupt("not written by smrt_writer");
+              if( getVarint() != smrt_serial::Version ) smrt_serial::corrupt("unknown version");
+            }
+
+    public: ~smrt_reader() { for(std::size_t i=0; i<_shared.size(); ++i) _shared[i].drop( _shared[i].ctrl ); }
+
+    private: smrt_reader(const smrt_reader&);
+    private: smrt_reader &operator=(const smrt_reader&);
+
+    // Pointers
+
+    public: template <typename T>
+            smrt_reader &get(shr<T> &p)
+            {
+              unsigned long long tag = getVarint();
+              if( tag == smrt_serial::Null ) { p.release(); return *this; }
+              if( tag >= smrt_serial::Ref )
+              {
+                if( tag - smrt_serial::Ref >= _shared.size() ) smrt_serial::corrupt("reference to an object not yet read");
+                _stats.backrefs += 1;
+                p = share<T>( _shared[tag - smrt_serial::Ref] );
+                return *this;
+              }
+
+              const smrt_serial::Type_t *d = dynamicType<T>( std::is_polymorphic<T>() );
+              Entry_t e;
+              Read_t  read;
+              if( d == NULL ) { e = entry<T>( makeShr<T>( std::is_default_constructible<T>() ) ); read = &smrt_serial::readObject<T>; }
+              else            { e = entry(*d);                                                     read = d->read;                    }
+
+              try        { p = share<T>(e); }
+              catch(...) { e.drop(e.ctrl); throw; }
+
+              if( tag == smrt_serial::Shared ) { _shared.push_back(e); _stats.shared += 1; }
+              else                               e.drop(e.ctrl);
+              return queue(e.ptr, read);
+            }
+
+    public: template <typename T>
+            smrt_reader &get(const_shr<T> &p)
+            {
+              shr<T> q;
+              get(q);
+              p = std::move(q);
+              return *this;
+            }
+
+    public: template <typename T>
+            smrt_reader &get(own<T> &p)
+            {
+              unsigned long long tag = getVarint();
+              if( tag == smrt_serial::Null )   { p.release(); return *this; }
+              if( tag != smrt_serial::Unique ) smrt_serial::corrupt("shared object read into an own<T>");
+
+              const smrt_serial::Type_t *d = dynamicType<T>( std::is_polymorphic<T>() );
+              if( d == NULL )
+              {
+                p = makeOwn<T>( std::is_default_constructible<T>() );
+                return queue( p.raw(), &smrt_serial::readObject<T> );
+              }
+
+              Entry_t e = { NULL, d->makeOwn(), d->type, d->ctrl, NULL };
+              T      *x;
+              try        { x = cast<T>(e); }
+              catch(...) { d->dispose(e.ptr); throw; }
+              p = x;
+              return queue(e.ptr, d->read);
+            }
+
+    // Values (see smrt_writer::put)
+
+    public: template <typename T, typename = typename std::enable_if< smrt_serial::isValue<T>::value >::type>
+            smrt_reader &get(T &x) { return read( &x, sizeof(T) ); }
+
+    public: template <typename T, typename = typename std::enable_if< smrt_serial::isAddress<T>::value >::type, typename = void>
+            smrt_reader &get(T &)
+            {
+              static_assert( sizeof(T) == 0, "smrt_reader::get: a raw pointer cannot be read, hold its object in a shr<T> or own<T>" );
+              return *this;
+            }
+
+    // The string grows as it is read, so a corrupt length runs out of stream
+    //   rather than allocating all of it up front
+
+    public: smrt_reader &get(std::string &s)
+            {
+              unsigned long long n = getVarint();
+              s.clear();
+              while( n > 0 )
+              {
+                std::size_t k = std::size_t( n < _buf.size() ? n : _buf.size() );
+                std::size_t m = s.size();
+                s.resize(m + k);
+                read(&s[m], k);
+                n -= k;
+              }
+              return *this;
+            }
+
+    public: unsigned long long getVarint(void)
+            {
+              unsigned long long v = 0;
+              for(unsigned shift=0; shift<64; shift+=7)
+              {
+                if( _pos == _end ) fill();
+                unsigned char b = (unsigned char)_buf[_pos++];
+                v |= (unsigned long long)( b & 0x7f ) << shift;
+                if( ( b & 0x80 ) == 0 ) return v;
+              }
+              smrt_serial::corrupt("malformed number");
+            }
+
+    // Blocks as large as the buffer bypass it
+
+    public: smrt_reader &read(void *p, std::size_t n)
+            {
+              char       *d = static_cast<char*>(p);
+              std::size_t k = ( n < _end-_pos ? n : _end-_pos );
+              std::memcpy( d, _buf.data() + _pos, k );
+              _pos += k;
+              d    += k;
+              n    -= k;
+              if( n >= _buf.size() ) { source(d, n, n); return *this; }
+              while( n > 0 )
+              {
+                fill();
+                k = ( n < _end ? n : _end );
+                std::memcpy( d, _buf.data(), k );
+                _pos = k;
+                d   += k;
+                n   -= k;
+              }
+              return *this;
+            }
+
+    public: const smrt_serial_stats &stats(void) const { return _stats; }
+
+    // Internal Methods
+
+    private: smrt_reader &queue(void *x, Read_t read)
+             {
+               _stats.objects += 1;
+               _pending.push_back( Pending_t(x, read) );
+               if( ! _draining ) drain();
+               return *this;
+             }
+
+    // The dynamic type written before a polymorphic object, or NULL if it
+    //   is T itself
+
+    private: template <typename T>
+             const smrt_serial::Type_t *dynamicType(std::false_type) { return NULL; }
+
+    private: template <typename T>
+             const smrt_serial::Type_t *dynamicType(std::true_type)
+             {
+               unsigned long long n = getVarint();
+               if( n == 0 ) return NULL;
+               if( n == _types.size()+1 )
+               {
+                 std::string name;
+                 get(name);
+                 const smrt_serial::Type_t *d = smrt_serial::find(name);
+                 if( d == NULL ) smrt_serial::corrupt( smrt_stats_registry::name(name.c_str()) + " is not registered (see smrt_serial::registerType)" );
+                 _types.push_back(d);
+               }
+               if( n > _types.size() ) smrt_serial::corrupt("unknown type");
+               return _types[n-1];
+             }
+
+    // Only a T written as a T itself is made here, so an abstract T (or
+    //   one with no default constructor) can only have been written as
+    //   some other class
+
+    private: template <typename T> static shr<T> makeShr(std::true_type)  { return make_shr<T>(); }
+    private: template <typename T> static T     *makeOwn(std::true_type)  { return new T(); }
+    private: template <typename T> static shr<T> makeShr(std::false_type) { smrt_serial::corrupt("object of a class which cannot be made"); }
+    private: template <typename T> static T     *makeOwn(std::false_type) { smrt_serial::corrupt("object of a class which cannot be made"); }
+
+    private: template <typename T>
+             static Entry_t entry(shr<T> p)
+             {
+               T      *x = p.raw();
+               Entry_t e = { shr_access::detach(p), x, &typeid(T), &typeid(typename shr<T>::Ctrl_t), &smrt_serial::drop<T> };
+               return e;
+             }
+
+    private: static Entry_t entry(const smrt_serial::Type_t &d)
+             {
+               void   *c = NULL;
+               void   *x = d.makeShr(&c);
+               Entry_t e = { c, x, d.type, d.ctrl, d.drop };
+               return e;
+             }
+
+    private: template <typename T>
+             static shr<T> share(const Entry_t &e)
+             {
+               typedef typename shr<T>::Ctrl_t Ctrl_t;
+
+               if( *e.counter != typeid(Ctrl_t) ) smrt_serial::corrupt("object read back with another counting policy");
+
+               T      *x = cast<T>(e);
+               Ctrl_t *c = static_cast<Ctrl_t*>(e.ctrl);
+               c->incr();
+               smrt_stats<T>::incr();
+               return shr_access::make< shr<T> >(c, x);
+             }
+
+    // The T within the object, found among the bases its type was
+    //   registered with
+
+    private: template <typename T>
+             static T *cast(const Entry_t &e)
+             {
+               if( *e.type == typeid(T) ) return static_cast<T*>(e.ptr);
+               smrt_serial::Upcast_t f = smrt_serial::findBase( *e.type, typeid(T) );
+               if( f == NULL ) smrt_serial::corrupt("object read back as an unrelated type");
+               return static_cast<T*>( f(e.ptr) );
+             }
+
+    private: void drain(void)
+             {
+               _draining = true;
+               try
+               {
+                 while( ! _pending.empty() )
+                 {
+                   Pending_t p = _pending.front();
+                   _pending.pop_front();
+                   p.second(p.first, *this);
+                 }
+               }
+               catch(...) { _pending.clear(); _draining = false; throw; }
+               _draining = false;
+             }
+
+    private: void fill(void)
+             {
+               _end = source( _buf.data(), 1, _buf.size() );
+               _pos = 0;
+             }
+
+    // Reads at least min and at most max bytes
+
+    private: std::size_t source(char *p, std::size_t min, std::size_t max)
+             {
+               std::size_t n = 0;
+               while( n < min )
+               {
+                 long k = long( ::read(_fd, p+n, max-n) );
+                 if( k < 0 && errno == EINTR ) continue;
+                 if( k < 0 )  smrt_serial::fail("smrt_reader");
+                 if( k == 0 ) smrt_serial::corrupt("unexpected end of stream");
+                 n += std::size_t(k);
+               }
+               _stats.bytes += n;
+               return n;
+             }
+
+    // Attributes
+
+    private: int                   _fd;
+    private: std::vector<char>     _buf;
+    private: std::size_t           _pos;
+    private: std::size_t           _end;
+    private: bool                  _draining;
+    private: std::deque<Pending_t> _pending;
+    private: std::vector<Entry_t>  _shared;
+    private: Types_t               _types;
+    private: smrt_serial_stats     _stats;
+  };
+
 #ifdef NS
 }
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+// std::hash, std::equal_to and std::less for the smart pointers (see
+//   smrt_hash above).  The array forms are covered by the same templates.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef NS
+#define SMARTPOINTER_NS_ ::NS::
+#else
+#define SMARTPOINTER_NS_ ::
+#endif
+
+#define SMARTPOINTER_STD_(P, ...) \
+  template <__VA_ARGS__> struct hash    < SMARTPOINTER_NS_ P > : SMARTPOINTER_NS_ smrt_hash  {}; \
+  template <__VA_ARGS__> struct equal_to< SMARTPOINTER_NS_ P > : SMARTPOINTER_NS_ smrt_equal {}; \
+  template <__VA_ARGS__> struct less    < SMARTPOINTER_NS_ P > : SMARTPOINTER_NS_ smrt_less  {};
+
+#define SMARTPOINTER_COMMA_ ,
+
+namespace std
+{
+  SMARTPOINTER_STD_( smrt<T>,                           typename T )
+  SMARTPOINTER_STD_( const_own<T SMARTPOINTER_COMMA_ D>, typename T, typename D )
+  SMARTPOINTER_STD_( own<T SMARTPOINTER_COMMA_ D>,       typename T, typename D )
+  SMARTPOINTER_STD_( const_shr<T>,                      typename T )
+  SMARTPOINTER_STD_( shr<T>,                            typename T )
+  SMARTPOINTER_STD_( const_ishr<T>,                     typename T )
+  SMARTPOINTER_STD_( ishr<T>,                           typename T )
+  SMARTPOINTER_STD_( const_cshr<T>,                     typename T )
+  SMARTPOINTER_STD_( cshr<T>,                           typename T )
+  SMARTPOINTER_STD_( const_ref<T>,                      typename T )
+  SMARTPOINTER_STD_( ref<T>,                            typename T )
+}
+
+#undef SMARTPOINTER_COMMA_
+#undef SMARTPOINTER_STD_
+#undef SMARTPOINTER_NS_
+
 #endif  // _SMARTPOINTERS_H_
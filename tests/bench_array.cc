@@ -0,0 +1,61 @@
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// A multiply-add kernel (y += a*x) over float arrays held by a raw
+//   pointer, by own<float[]> through operator[], and by the views of
+//   make_aligned_shr<float> arrays.  The smart pointer loops should match
+//   the raw loop, as neither the index nor the pointer is checked.
+//------------------------------------------------------------
+
+void axpy(float a, const float *x, float *y, std::size_t n)
+{
+  for(std::size_t i=0; i<n; ++i) y[i] += a*x[i];
+}
+
+void axpy(float a, const own<float[]> &x, own<float[]> &y)
+{
+  for(std::size_t i=0; i<y.size(); ++i) y[i] += a*x[i];
+}
+
+void axpy(float a, const_ref<float[]> x, ref<float[]> y)
+{
+  const float *xi = x.begin();
+  for(float *yi=y.begin(); yi!=y.end(); ++yi, ++xi) *yi += a * *xi;
+}
+
+template <typename F>
+  void run(const std::string &name, std::size_t n, unsigned passes, F f)
+  {
+    BenchTimer timer;
+    for(unsigned pass=0; pass<passes; ++pass) f();
+    bench_report(name, n*passes, timer.seconds());
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  std::size_t n      = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 4096UL );
+  unsigned    passes = 20000;
+
+  bench_title("axpy (y += a*x) over float arrays of " + std::to_string(n) + " elements x " + std::to_string(passes) + " passes");
+
+  float *rx = new float[n]();
+  float *ry = new float[n]();
+  run("raw new[] pointers", n, passes, [&]{ axpy(0.5f, rx, ry, n); bench_keep(ry[0]); });
+  delete[] rx;
+  delete[] ry;
+
+  own<float[]> ox( new float[n](), n );
+  own<float[]> oy( new float[n](), n );
+  run("own<float[]> operator[]", n, passes, [&]{ axpy(0.5f, ox, oy); bench_keep(oy[0]); });
+
+  shr<float[]> sx = make_aligned_shr<float>(n);
+  shr<float[]> sy = make_aligned_shr<float>(n);
+  run("aligned shr<float[]> through ref<T[]>", n, passes, [&]{ axpy(0.5f, sx, sy); bench_keep(sy[0]); });
+
+  bench_done();
+  return 0;
+}
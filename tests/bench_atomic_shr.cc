@@ -0,0 +1,98 @@
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// Readers repeatedly take a snapshot of a published table while one
+//   writer republishes it.  Compares a const_shr<T> slot guarded by a
+//   mutex with an atomic_shr<T> cell.
+//------------------------------------------------------------
+
+struct Table { long entries[16]; };
+
+template <> struct shr_counting<Table> { typedef shr_atomic_count Policy_t; };
+
+struct MutexSlot
+{
+  std::mutex      lock;
+  const_shr<Table> value;
+
+  const_shr<Table> load(void)                     { std::lock_guard<std::mutex> g(lock); return value; }
+  void             store(const const_shr<Table> &p) { std::lock_guard<std::mutex> g(lock); value = p; }
+};
+
+struct AtomicSlot
+{
+  atomic_shr<Table> value;
+
+  const_shr<Table> load(void)                     { return value.load(); }
+  void             store(const const_shr<Table> &p) { value.store(p); }
+};
+
+template <typename S>
+  void reader(S &slot, unsigned long n)
+  {
+    for(unsigned long i=0; i<n; ++i)
+    {
+      const_shr<Table> t = slot.load();
+      bench_keep(t->entries[i & 15]);
+    }
+  }
+
+template <typename S>
+  void writer(S &slot, const std::atomic<bool> &stop)
+  {
+    while( ! stop.load(std::memory_order_relaxed) )
+    {
+      slot.store( make_const_shr<Table>() );
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+template <typename S>
+  double run(unsigned nreader, unsigned long n)
+  {
+    S slot;
+    slot.store( make_const_shr<Table>() );
+
+    std::atomic<bool> stop(false);
+    std::thread w(writer<S>, std::ref(slot), std::cref(stop));
+
+    std::vector<std::thread> readers;
+    BenchTimer timer;
+    for(unsigned t=0; t<nreader; ++t) readers.push_back( std::thread(reader<S>, std::ref(slot), n) );
+    for(unsigned t=0; t<nreader; ++t) readers[t].join();
+    double secs = timer.seconds();
+
+    stop = true;
+    w.join();
+    return secs;
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 2000000UL );
+
+  bench_title("snapshot loads of a republished table, " + std::to_string(n) + " loads per reader");
+
+  for(unsigned nreader=1; nreader<=8; nreader*=2)
+  {
+    bench_report("mutex+const_shr  readers=" + std::to_string(nreader), nreader*n, run<MutexSlot>(nreader, n));
+    bench_report("atomic_shr       readers=" + std::to_string(nreader), nreader*n, run<AtomicSlot>(nreader, n));
+  }
+
+  smrt_hazard::scan();
+  smrt_hazard_stats s = smrt_hazard::stats();
+  bench_value("hazard records",  s.records);
+  bench_value("hazard retired",  s.retired);
+  bench_value("hazard pending",  s.pending);
+
+  bench_done();
+  return 0;
+}
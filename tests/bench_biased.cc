@@ -0,0 +1,127 @@
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+// Three otherwise identical payloads so that each can use its own counting policy
+
+struct PlainObj  { long value; };
+struct AtomicObj { long value; };
+struct BiasedObj { long value; };
+
+template <> struct shr_counting<AtomicObj> { typedef shr_atomic_count Policy_t; };
+template <> struct shr_counting<BiasedObj> { typedef shr_biased_count Policy_t; };
+
+//------------------------------------------------------------
+// Copies and destroys a shr<T> n times on the calling thread.  When the
+//   calling thread created src, the biased count takes its owner path.
+//------------------------------------------------------------
+
+template <typename T>
+  void copier(const shr<T> &src, unsigned long n)
+  {
+    for(unsigned long i=0; i<n; ++i)
+    {
+      shr<T> copy = src;
+      bench_keep(copy);
+    }
+  }
+
+// Occasional copies from other threads until told to stop
+
+template <typename T>
+  void visitor(const shr<T> &src, const std::atomic<bool> &stop)
+  {
+    while( ! stop.load(std::memory_order_relaxed) )
+    {
+      for(int i=0; i<100; ++i) { shr<T> copy = src; bench_keep(copy); }
+      std::this_thread::yield();
+    }
+  }
+
+template <typename T>
+  double owner_only(unsigned long n)
+  {
+    shr<T> src = make_shr<T>();
+    BenchTimer timer;
+    copier(src, n);
+    return timer.seconds();
+  }
+
+template <typename T>
+  double owner_with_visitors(unsigned long n, unsigned nvisitor)
+  {
+    shr<T> src = make_shr<T>();
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> visitors;
+    for(unsigned t=0; t<nvisitor; ++t) visitors.push_back( std::thread(visitor<T>, std::cref(src), std::cref(stop)) );
+
+    BenchTimer timer;
+    copier(src, n);
+    double secs = timer.seconds();
+
+    stop = true;
+    for(unsigned t=0; t<nvisitor; ++t) visitors[t].join();
+    return secs;
+  }
+
+// Every thread (including the owner) copies equally
+
+template <typename T>
+  double all_shared(unsigned long n, unsigned nthread)
+  {
+    shr<T> src = make_shr<T>();
+    std::vector<std::thread> workers;
+
+    BenchTimer timer;
+    for(unsigned t=0; t<nthread; ++t) workers.push_back( std::thread(copier<T>, std::cref(src), n) );
+    for(unsigned t=0; t<nthread; ++t) workers[t].join();
+    return timer.seconds();
+  }
+
+// Objects created on one thread and released on another (the biased
+//   count frees them when the owner next collects)
+
+template <typename T>
+  double handoff(unsigned long n)
+  {
+    std::vector< shr<T> > made(n);
+    for(unsigned long i=0; i<n; ++i) { made[i] = make_shr<T>(); shr<T> copy = made[i]; bench_keep(copy); }
+
+    BenchTimer timer;
+    std::thread t( [&made]{ made.clear(); } );
+    t.join();
+    shr_biased_count::collect();
+    return timer.seconds();
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 10000000UL );
+
+  bench_title("owner thread copy/destroy, " + std::to_string(n) + " copies");
+  bench_report("plain",  n, owner_only<PlainObj>(n));
+  bench_report("atomic", n, owner_only<AtomicObj>(n));
+  bench_report("biased", n, owner_only<BiasedObj>(n));
+
+  bench_title("owner thread copy/destroy with 2 occasional visitor threads");
+  bench_report("atomic", n, owner_with_visitors<AtomicObj>(n, 2));
+  bench_report("biased", n, owner_with_visitors<BiasedObj>(n, 2));
+
+  unsigned long m = n / 4;
+  bench_title("4 threads copying equally, " + std::to_string(m) + " copies per thread");
+  bench_report("atomic", 4*m, all_shared<AtomicObj>(m, 4));
+  bench_report("biased", 4*m, all_shared<BiasedObj>(m, 4));
+
+  unsigned long k = n / 10;
+  bench_title("release on another thread, " + std::to_string(k) + " objects");
+  bench_report("atomic", k, handoff<AtomicObj>(k));
+  bench_report("biased", k, handoff<BiasedObj>(k));
+
+  bench_done();
+  return 0;
+}
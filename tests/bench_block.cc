@@ -0,0 +1,59 @@
+#include <vector>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+struct Record { long key; long value; Record(void) : key(0), value(1) {} };
+
+//------------------------------------------------------------
+// Loading a batch of n records, summing them, and freeing the batch: one
+//   shr<Record>(new Record) per element, against one make_shr_block<Record>
+//   iterated directly and through per element handles.
+//------------------------------------------------------------
+
+template <typename F>
+  void run(const std::string &name, unsigned long n, unsigned passes, F f)
+  {
+    BenchTimer timer;
+    for(unsigned pass=0; pass<passes; ++pass) f();
+    bench_report(name, n*passes, timer.seconds());
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n      = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 100000UL );
+  unsigned      passes = 50;
+
+  bench_title("load, sum and free " + std::to_string(n) + " records x " + std::to_string(passes) + " passes");
+
+  run("shr<Record>(new Record) each", n, passes, [n]{
+    std::vector< shr<Record> > v;
+    v.reserve(n);
+    for(unsigned long i=0; i<n; ++i) v.push_back( shr<Record>(new Record) );
+    long sum = 0;
+    for(unsigned long i=0; i<n; ++i) sum += v[i]->value;
+    bench_keep(sum);
+  });
+
+  run("make_shr_block<Record> iterated", n, passes, [n]{
+    shr<Record[]> b = make_shr_block<Record>(n);
+    long sum = 0;
+    for(const Record *i=b.begin(); i!=b.end(); ++i) sum += i->value;
+    bench_keep(sum);
+  });
+
+  run("make_shr_block<Record> element handles", n, passes, [n]{
+    shr<Record[]> b = make_shr_block<Record>(n);
+    std::vector< shr<Record> > v;
+    v.reserve(n);
+    for(unsigned long i=0; i<n; ++i) v.push_back( b.element(i) );
+    long sum = 0;
+    for(unsigned long i=0; i<n; ++i) sum += v[i]->value;
+    bench_keep(sum);
+  });
+
+  bench_done();
+  return 0;
+}
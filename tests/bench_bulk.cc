@@ -0,0 +1,73 @@
+#include <vector>
+#include <iterator>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+struct Item       { long value; };
+struct AtomicItem { long value; };
+
+template <> struct shr_counting<AtomicItem> { typedef shr_atomic_count Policy_t; };
+
+//------------------------------------------------------------
+// Copying and then releasing a vector of n shr<Item> which holds d
+//   distinct pointers, scattered, element by element (vector insert and
+//   clear) and in bulk (shr_copy and shr_clear), with plain and atomic
+//   counts.  The bulk forms only pay off with atomic counts and few
+//   distinct pointers.
+//------------------------------------------------------------
+
+template <typename F>
+  void run(const std::string &name, unsigned long n, unsigned passes, F f)
+  {
+    BenchTimer timer;
+    for(unsigned pass=0; pass<passes; ++pass) f();
+    bench_report(name, n*passes, timer.seconds());
+  }
+
+template <typename T>
+  void fanout(const std::string &label, unsigned long n, unsigned long d, unsigned passes)
+  {
+    std::vector< shr<T> > items;
+    for(unsigned long i=0; i<d; ++i) items.push_back( new T() );
+
+    std::vector< shr<T> > src;
+    src.reserve(n);
+    for(unsigned long i=0; i<n; ++i) src.push_back( items[ (i*2654435761UL) % d ] );
+
+    std::string tag = " " + label + " distinct=" + std::to_string(d);
+
+    run("insert + clear" + tag, n, passes, [&]{
+      std::vector< shr<T> > dst;
+      dst.insert(dst.end(), src.begin(), src.end());
+      dst.clear();
+    });
+
+    run("shr_copy + shr_clear" + tag, n, passes, [&]{
+      std::vector< shr<T> > dst;
+      dst.reserve(src.size());
+      shr_copy(src.begin(), src.end(), std::back_inserter(dst));
+      shr_clear(dst);
+    });
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n      = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 1000000UL );
+  unsigned      passes = 10;
+
+  bench_title("copy and release of vectors of " + std::to_string(n) + " shr<Item> with duplicated pointers");
+
+  fanout<Item>("plain", n, 16,   passes);
+  fanout<Item>("plain", n, 4096, passes);
+  fanout<Item>("plain", n, n,    passes);
+
+  fanout<AtomicItem>("atomic", n, 16,   passes);
+  fanout<AtomicItem>("atomic", n, 4096, passes);
+  fanout<AtomicItem>("atomic", n, n,    passes);
+
+  bench_done();
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include <vector>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// Sums a field across a vector<shr<T>> using each of the NULL checking
+//   policies.  The payloads are identical, each selects its own policy.
+//   Note that this program is built without NDEBUG, so the assert policy
+//   shows the cost of a debug build.
+//------------------------------------------------------------
+
+template <int N> struct Obj { long value; };
+
+typedef Obj<0> ThrowObj;
+typedef Obj<1> AssertObj;
+typedef Obj<2> TrapObj;
+typedef Obj<3> NoneObj;
+
+template <> struct smrt_checking<AssertObj> { typedef smrt_check_assert Policy_t; };
+template <> struct smrt_checking<TrapObj>   { typedef smrt_check_trap   Policy_t; };
+template <> struct smrt_checking<NoneObj>   { typedef smrt_check_none   Policy_t; };
+
+template <typename T>
+  long sum(const std::vector< shr<T> > &v)
+  {
+    long rval = 0;
+    for(typename std::vector< shr<T> >::const_iterator x=v.begin(); x!=v.end(); ++x) rval += (*x)->value;
+    return rval;
+  }
+
+template <typename T>
+  long sum(const std::vector<T*> &v)
+  {
+    long rval = 0;
+    for(typename std::vector<T*>::const_iterator x=v.begin(); x!=v.end(); ++x) rval += (*x)->value;
+    return rval;
+  }
+
+template <typename V>
+  void run(const std::string &name, const V &v, unsigned passes)
+  {
+    long total = 0;
+    BenchTimer timer;
+    for(unsigned pass=0; pass<passes; ++pass) { total += sum(v); bench_keep(v); }
+    bench_report(name, v.size()*passes, timer.seconds());
+    bench_keep(total);
+  }
+
+template <typename T>
+  void fill(std::vector< shr<T> > &v, unsigned long n)
+  {
+    for(unsigned long i=0; i<n; ++i) { v.push_back( make_shr<T>() ); v.back()->value = i; }
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n      = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 10000UL );
+  unsigned      passes = 2000;
+
+  bench_title("sum over vector<shr<T>> of " + std::to_string(n) + " elements x " + std::to_string(passes) + " passes");
+
+  std::vector< shr<ThrowObj>  > vthrow;   fill(vthrow,  n);
+  std::vector< shr<AssertObj> > vassert;  fill(vassert, n);
+  std::vector< shr<TrapObj>   > vtrap;    fill(vtrap,   n);
+  std::vector< shr<NoneObj>   > vnone;    fill(vnone,   n);
+  std::vector< NoneObj*       > vraw;     for(unsigned long i=0; i<n; ++i) vraw.push_back(vnone[i].raw());
+
+  run("raw pointer",        vraw,    passes);
+  run("smrt_check_throw",   vthrow,  passes);
+  run("smrt_check_assert",  vassert, passes);
+  run("smrt_check_trap",    vtrap,   passes);
+  run("smrt_check_none",    vnone,   passes);
+
+  bench_done();
+  return 0;
+}
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstring>
+#include <chrono>
+
+//------------------------------------------------------------
+// Support shared by the bench_* programs
+//
+//   Results are written as aligned text by default.  Pass --csv or --json
+//   on the command line for machine readable output suitable for tracking
+//   regressions between releases.  Each record names the program, the
+//   measurement, and either an operation count and time or a single value.
+//------------------------------------------------------------
+
+class BenchTimer
+{
+  public:
+    BenchTimer(void) { start(); }
+
+    void start(void) { _start = std::chrono::steady_clock::now(); }
+
+    double seconds(void) const
+    {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    }
+
+  private:
+    std::chrono::steady_clock::time_point _start;
+};
+
+// Prevents the optimizer from discarding a value computed in a benchmark loop
+
+template <typename T>
+inline void bench_keep(const T &x) { asm volatile("" : : "g"(&x) : "memory"); }
+
+enum BenchFormat { BenchText, BenchCsv, BenchJson };
+
+struct BenchState
+{
+  BenchFormat format;
+  std::string program;
+  int         records;
+};
+
+inline BenchState &bench_state(void) 
+{ 
+  static BenchState state = { BenchText, "bench", 0 }; 
+  return state; 
+}
+
+inline std::string bench_quote(const std::string &s)
+{
+  std::string rval = "\"";
+  for(size_t i=0; i<s.size(); ++i)
+  {
+    if(s[i]=='"' || s[i]=='\\') rval += '\\';
+    rval += s[i];
+  }
+  return rval + "\"";
+}
+
+// Strips the output format options from the command line, leaving any others
+
+inline void bench_init(int &argc, const char **argv)
+{
+  BenchState &state = bench_state();
+  const char *slash = std::strrchr(argv[0],'/');
+  state.program = ( slash ? slash+1 : argv[0] );
+
+  int n = 1;
+  for(int i=1; i<argc; ++i)
+  {
+    if     ( std::strcmp(argv[i],"--csv")  == 0 ) state.format = BenchCsv;
+    else if( std::strcmp(argv[i],"--json") == 0 ) state.format = BenchJson;
+    else argv[n++] = argv[i];
+  }
+  argc = n;
+
+  if( state.format == BenchCsv  ) std::cout << "bench,name,ops,seconds,ns_per_op,value" << std::endl;
+  if( state.format == BenchJson ) std::cout << "[" << std::endl;
+}
+
+inline void bench_done(void)
+{
+  if( bench_state().format == BenchJson ) std::cout << std::endl << "]" << std::endl;
+}
+
+// Free form commentary, only shown as text
+
+inline void bench_title(const std::string &text)
+{
+  if( bench_state().format == BenchText ) std::cout << text << std::endl << std::endl;
+}
+
+inline void bench_record(const std::string &name, unsigned long ops, double seconds, double value)
+{
+  BenchState &state = bench_state();
+  double      ns    = ( ops ? 1.0e9*seconds/ops : 0.0 );
+
+  if( state.format == BenchCsv )
+  {
+    std::cout << state.program << "," << bench_quote(name) << "," << ops << "," 
+              << std::setprecision(9) << seconds << "," << ns << "," << value << std::endl;
+  }
+  else if( state.format == BenchJson )
+  {
+    std::cout << ( state.records ? ",\n" : "" ) << "  {\"bench\": " << bench_quote(state.program)
+              << ", \"name\": " << bench_quote(name) << ", \"ops\": " << ops 
+              << std::setprecision(9) << ", \"seconds\": " << seconds << ", \"ns_per_op\": " << ns 
+              << ", \"value\": " << value << "}";
+  }
+  state.records += 1;
+}
+
+// A timed measurement of ops operations
+
+inline void bench_report(const std::string &name, unsigned long ops, double seconds)
+{
+  if( bench_state().format == BenchText )
+  {
+    std::cout << std::left  << std::setw(44) << name 
+              << std::right << std::setw(12) << ops << " ops " 
+              << std::fixed << std::setprecision(3) << std::setw(10) << seconds << " s " 
+              << std::setprecision(2) << std::setw(10) << (1.0e9*seconds/ops) << " ns/op" 
+              << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+  }
+  bench_record(name, ops, seconds, 0);
+}
+
+// Any other measured quantity (counts, bytes, ...)
+
+inline void bench_value(const std::string &name, double value)
+{
+  if( bench_state().format == BenchText )
+  {
+    std::cout << "    " << std::left << std::setw(40) << name << std::right << std::setw(12) 
+              << std::setprecision(12) << value << std::endl;
+  }
+  bench_record(name, 0, 0, value);
+}
@@ -0,0 +1,106 @@
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+struct Plain;
+struct Cyclic;
+
+template <> struct shr_counting<Cyclic> { typedef shr_cycle_count Policy_t; };
+
+struct Plain  { long value; shr<Plain>  next; shr<Plain>  prev; };
+struct Cyclic { long value; shr<Cyclic> next; shr<Cyclic> prev; void shrTrace(shr_tracer &t) const { t(next)(prev); } };
+
+//------------------------------------------------------------
+// The cost of cycle collection: copying and releasing shr<T> with and
+//   without shr_cycle_count, then dropping n doubly linked rings of len
+//   nodes and collecting them in one pause, and again in slices of a
+//   fixed budget.
+//------------------------------------------------------------
+
+template <typename F>
+  void run(const std::string &name, unsigned long n, unsigned passes, F f)
+  {
+    BenchTimer timer;
+    for(unsigned pass=0; pass<passes; ++pass) f();
+    bench_report(name, n*passes, timer.seconds());
+  }
+
+template <typename T>
+  void copies(const std::string &name, unsigned long n)
+  {
+    shr<T> p = make_shr<T>();
+    std::vector< shr<T> > v;
+    v.reserve(n);
+    run(name, n, 20, [&]{
+      for(unsigned long i=0; i<n; ++i) v.push_back(p);
+      v.clear();
+    });
+    shr_cycles::collect();
+  }
+
+void rings(unsigned long n, unsigned long len)
+{
+  for(unsigned long r=0; r<n; ++r)
+  {
+    shr<Cyclic> first = make_shr<Cyclic>();
+    shr<Cyclic> last  = first;
+    for(unsigned long i=1; i<len; ++i)
+    {
+      shr<Cyclic> c = make_shr<Cyclic>();
+      c->prev    = last;
+      last->next = c;
+      last       = c;
+    }
+    last->next  = first;
+    first->prev = last;
+  }
+}
+
+void report(const std::string &label, const shr_cycle_stats &before, unsigned long calls, unsigned long worst)
+{
+  shr_cycle_stats s = shr_cycles::stats();
+  bench_value(label + " objects freed",    double(s.collected - before.collected));
+  bench_value(label + " bytes freed",      double(s.bytes - before.bytes));
+  bench_value(label + " collect() calls",  double(calls));
+  bench_value(label + " worst pause (us)", worst / 1000.0);
+  bench_value(label + " total pause (us)", (s.totalPauseNs - before.totalPauseNs) / 1000.0);
+}
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n   = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 10000UL );
+  unsigned long len = 8;
+
+  bench_title("copy/release of shr<T>, then " + std::to_string(n) + " garbage rings of " + std::to_string(len) + " nodes");
+
+  copies<Plain> ("copy+release shr_plain_count", 100000);
+  copies<Cyclic>("copy+release shr_cycle_count", 100000);
+
+  shr_cycle_stats before = shr_cycles::stats();
+  rings(n, len);
+  BenchTimer timer;
+  shr_cycles::collect();
+  bench_report("collect() all at once (per object)", n*len, timer.seconds());
+  report("single pause:", before, 1, shr_cycles::stats().lastPauseNs);
+
+  rings(n, len);
+  before = shr_cycles::stats();
+  unsigned long calls = 0;
+  unsigned long worst = 0;
+  timer.start();
+  while( shr_cycles::pending() > 0 )
+  {
+    shr_cycles::collect( std::chrono::microseconds(200) );
+    calls += 1;
+    if( shr_cycles::stats().lastPauseNs > worst ) worst = shr_cycles::stats().lastPauseNs;
+  }
+  bench_report("collect(200us) slices (per object)", n*len, timer.seconds());
+  report("200us slices:", before, calls, worst);
+
+  bench_done();
+  return 0;
+}
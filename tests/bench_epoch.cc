@@ -0,0 +1,97 @@
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// Readers repeatedly look up an entry in a published table while one
+//   writer republishes it.  Compares a counted snapshot from an
+//   atomic_shr<T> with a const_ref<T> from an epoch_own<T> read inside
+//   an smrt_epoch::Guard, which touches no reference count.
+//------------------------------------------------------------
+
+struct Table { long entries[16]; };
+
+template <> struct shr_counting<Table> { typedef shr_atomic_count Policy_t; };
+
+struct SnapshotSlot
+{
+  atomic_shr<Table> value;
+
+  long lookup(unsigned long i) const { const_shr<Table> t = value.load(); return t->entries[i & 15]; }
+  void publish(void)                 { value.store( make_const_shr<Table>() ); }
+};
+
+struct EpochSlot
+{
+  epoch_own<Table> value;
+
+  long lookup(unsigned long i) const { smrt_epoch::Guard g; const_ref<Table> t = value.load(); return t->entries[i & 15]; }
+  void publish(void)                 { value.store( new Table() ); }
+};
+
+template <typename S>
+  void reader(const S &slot, unsigned long n)
+  {
+    for(unsigned long i=0; i<n; ++i)
+    {
+      long x = slot.lookup(i);
+      bench_keep(x);
+    }
+  }
+
+template <typename S>
+  void writer(S &slot, const std::atomic<bool> &stop)
+  {
+    while( ! stop.load(std::memory_order_relaxed) )
+    {
+      slot.publish();
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+template <typename S>
+  double run(unsigned nreader, unsigned long n)
+  {
+    S slot;
+    slot.publish();
+
+    std::atomic<bool> stop(false);
+    std::thread w(writer<S>, std::ref(slot), std::cref(stop));
+
+    std::vector<std::thread> readers;
+    BenchTimer timer;
+    for(unsigned t=0; t<nreader; ++t) readers.push_back( std::thread(reader<S>, std::cref(slot), n) );
+    for(unsigned t=0; t<nreader; ++t) readers[t].join();
+    double secs = timer.seconds();
+
+    stop = true;
+    w.join();
+    return secs;
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 2000000UL );
+
+  bench_title("lookups in a republished table, " + std::to_string(n) + " lookups per reader");
+
+  for(unsigned nreader=1; nreader<=8; nreader*=2)
+  {
+    bench_report("atomic_shr snapshot  readers=" + std::to_string(nreader), nreader*n, run<SnapshotSlot>(nreader, n));
+    bench_report("epoch const_ref      readers=" + std::to_string(nreader), nreader*n, run<EpochSlot>(nreader, n));
+  }
+
+  smrt_epoch::synchronize();
+  smrt_epoch_stats s = smrt_epoch::stats();
+  bench_value("epoch advances", s.advances);
+  bench_value("epoch retired",  s.retired);
+  bench_value("epoch pending",  s.pending);
+
+  bench_done();
+  return 0;
+}
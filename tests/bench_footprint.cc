@@ -0,0 +1,132 @@
+#include <vector>
+#include <set>
+#include <memory>
+#include <cstdlib>
+#include <malloc.h>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// Heap footprint of large containers of shared pointers.  Every
+//   allocation is tallied (by its usable size, i.e. including malloc's
+//   rounding but not its bookkeeping) so that the bytes per element of
+//   each container, handles and objects together, can be reported.  The
+//   time to fill the container and to sum through it is reported too.
+//------------------------------------------------------------
+
+static long heap_bytes = 0;
+
+static void *heap_alloc(std::size_t n)
+{
+  void *p = std::malloc(n ? n : 1);
+  if( p == NULL ) throw std::bad_alloc();
+  heap_bytes += malloc_usable_size(p);
+  return p;
+}
+
+static void heap_free(void *p) noexcept
+{
+  if( p != NULL ) heap_bytes -= malloc_usable_size(p);
+  std::free(p);
+}
+
+// Every form of new is matched by every form of delete which may release it
+
+void *operator new(std::size_t n)   { return heap_alloc(n); }
+void *operator new[](std::size_t n) { return heap_alloc(n); }
+
+void operator delete(void *p) noexcept                     { heap_free(p); }
+void operator delete(void *p, std::size_t) noexcept        { heap_free(p); }
+void operator delete[](void *p) noexcept                   { heap_free(p); }
+void operator delete[](void *p, std::size_t) noexcept      { heap_free(p); }
+
+//------------------------------------------------------------
+// An 8 byte object, and a 20 byte one (aligned to 4 bytes) with either
+//   the default count or a 32-bit count.  The 32-bit count brings the
+//   latter's block down to 24 bytes, a smaller malloc size class.
+//------------------------------------------------------------
+
+struct Obj   { long value; };
+struct Rec   { int  value; int data[4]; };
+struct Rec32 { int  value; int data[4]; };
+
+template <> struct cshr_counting<Rec32> { typedef shr_plain_count32 Policy_t; };
+
+// Makes the n'th element of each kind of container
+
+template <typename S> struct maker;
+
+template <typename T> struct maker<T*>                   { static T*                   make(long i) { T *p = new T; p->value = i; return p; } };
+template <typename T> struct maker< shr<T> >             { static shr<T>               make(long i) { shr<T> p = make_shr<T>(); p->value = i; return p; } };
+template <typename T> struct maker< cshr<T> >            { static cshr<T>              make(long i) { cshr<T> p = make_cshr<T>(); p->value = i; return p; } };
+template <typename T> struct maker< std::shared_ptr<T> > { static std::shared_ptr<T>   make(long i) { std::shared_ptr<T> p = std::make_shared<T>(); p->value = i; return p; } };
+
+template <typename S> void clear(std::vector<S> &) {}
+template <typename T> void clear(std::vector<T*> &v) { for(std::size_t i=0; i<v.size(); ++i) delete v[i]; }
+
+template <typename C>
+  long sum(const C &c)
+  {
+    long rval = 0;
+    for(typename C::const_iterator x=c.begin(); x!=c.end(); ++x) rval += (*x)->value;
+    return rval;
+  }
+
+template <typename S>
+  void run_vector(const std::string &name, unsigned long n)
+  {
+    long before = heap_bytes;
+    BenchTimer timer;
+    std::vector<S> v;
+    v.reserve(n);
+    for(unsigned long i=0; i<n; ++i) v.push_back( maker<S>::make(i) );
+    bench_report("vector<" + name + "> fill", n, timer.seconds());
+
+    timer.start();
+    long total = sum(v);
+    bench_report("vector<" + name + "> sum", n, timer.seconds());
+    bench_keep(total);
+
+    bench_value("vector<" + name + "> sizeof(handle)", sizeof(S));
+    bench_value("vector<" + name + "> bytes per element", double(heap_bytes - before)/n);
+    clear(v);
+  }
+
+template <typename S>
+  void run_set(const std::string &name, unsigned long n)
+  {
+    long before = heap_bytes;
+    BenchTimer timer;
+    std::set<S> s;
+    for(unsigned long i=0; i<n; ++i) s.insert( s.end(), maker<S>::make(i) );
+    bench_report("set<" + name + "> fill", n, timer.seconds());
+
+    timer.start();
+    long total = sum(s);
+    bench_report("set<" + name + "> sum", n, timer.seconds());
+    bench_keep(total);
+
+    bench_value("set<" + name + "> bytes per element", double(heap_bytes - before)/n);
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 10000000UL );
+
+  bench_title("heap footprint of containers of " + std::to_string(n) + " shared pointers");
+
+  run_vector< Obj* >                  ("Obj* (raw)",          n);
+  run_vector< std::shared_ptr<Obj> >  ("std::shared_ptr<Obj>", n);
+  run_vector< shr<Obj> >              ("shr<Obj>",            n);
+  run_vector< cshr<Obj> >             ("cshr<Obj>",           n);
+  run_vector< cshr<Rec> >             ("cshr<Rec>",           n);
+  run_vector< cshr<Rec32> >           ("cshr<Rec32>",         n);
+
+  run_set< shr<Obj> >                 ("shr<Obj>",            n);
+  run_set< cshr<Obj> >                ("cshr<Obj>",           n);
+
+  bench_done();
+  return 0;
+}
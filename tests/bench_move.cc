@@ -0,0 +1,62 @@
+#include <vector>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// A plain counting policy which also tallies every update made to
+//   the count so that the benchmark can report them.
+//------------------------------------------------------------
+
+struct tally_count : public shr_plain_count
+{
+  static unsigned long updates;
+
+  static void incr(Count_t &c) { ++updates; shr_plain_count::incr(c); }
+  static bool decr(Count_t &c) { ++updates; return shr_plain_count::decr(c); }
+};
+
+unsigned long tally_count::updates = 0;
+
+struct Obj { long value; };
+
+template <> struct shr_counting<Obj> { typedef tally_count Policy_t; };
+
+// Hides the move constructor so that std::vector must copy on growth
+
+struct CopyOnly : public shr<Obj>
+{
+  CopyOnly(Obj *p) : shr<Obj>(p) {}
+  CopyOnly(const CopyOnly &p) : shr<Obj>(p) {}
+};
+
+template <typename S>
+  void grow(const char *name, unsigned long n)
+  {
+    tally_count::updates = 0;
+    BenchTimer timer;
+    {
+      std::vector<S> v;
+      for(unsigned long i=0; i<n; ++i) v.push_back( S(new Obj) );
+      bench_keep(v);
+    }
+    double secs = timer.seconds();
+
+    bench_report(name, n, secs);
+    bench_value(std::string(name) + " count updates", tally_count::updates);
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 1000000UL );
+
+  bench_title("vector<shr<T>> growth by push_back of " + std::to_string(n) + " temporaries");
+
+  grow<CopyOnly>("copy only (no move constructor)", n);
+  grow< shr<Obj> >("shr<T> with move", n);
+
+  bench_done();
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include <vector>
+#include <thread>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+// Two otherwise identical payloads, only one of which uses the slab pool
+
+struct HeapObj   { long value; };
+struct PooledObj { long value; };
+
+template <> struct shr_pooling<PooledObj> { static const bool value = true; };
+
+//------------------------------------------------------------
+// Each pass wraps n new objects in shr<T> and then releases them in a
+//   scattered order.  Both runs pay the same cost for new T, so the
+//   difference is in the allocation of the reference counts.
+//------------------------------------------------------------
+
+template <typename T>
+  double run(unsigned long n, unsigned passes)
+  {
+    BenchTimer timer;
+    for(unsigned pass=0; pass<passes; ++pass)
+    {
+      std::vector< shr<T> > live;
+      live.reserve(n);
+      for(unsigned long i=0; i<n; ++i) live.push_back( shr<T>(new T) );
+      for(unsigned long i=0; i<n; i+=2) live[i].release();
+      for(unsigned long i=1; i<n; i+=2) live[i].release();
+    }
+    return timer.seconds();
+  }
+
+template <typename T>
+  void threaded(unsigned nthread, unsigned long n, unsigned passes)
+  {
+    std::vector<std::thread> workers;
+    for(unsigned t=0; t<nthread; ++t) workers.push_back(std::thread(run<T>, n, passes));
+    for(unsigned t=0; t<nthread; ++t) workers[t].join();
+  }
+
+void show(const std::string &name, const shr_slab_stats &s)
+{
+  bench_value(name + " slot size", s.slotSize);
+  bench_value(name + " pages",     s.pages);
+  bench_value(name + " reserved",  s.reserved);
+  bench_value(name + " allocs",    s.allocs);
+  bench_value(name + " frees",     s.frees);
+  bench_value(name + " live",      s.live);
+  bench_value(name + " refills",   s.refills);
+  bench_value(name + " flushes",   s.flushes);
+}
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n      = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 100000UL );
+  unsigned      passes = 20;
+
+  typedef shr_slab< sizeof(shr_ctrl_ptr<PooledObj, shr_counting<PooledObj>::Policy_t>) > Slab_t;
+
+  bench_title("shr<T>(new T) create/release, " + std::to_string(n) + " pointers x " + std::to_string(passes) + " passes");
+
+  bench_report("system allocator", n*passes, run<HeapObj>(n, passes));
+  bench_report("slab pool",        n*passes, run<PooledObj>(n, passes));
+  show("slab", Slab_t::stats());
+
+  unsigned nthread = 4;
+  BenchTimer timer;
+  threaded<HeapObj>(nthread, n, passes);
+  bench_report("system allocator threads=4", nthread*n*passes, timer.seconds());
+
+  timer.start();
+  threaded<PooledObj>(nthread, n, passes);
+  bench_report("slab pool threads=4", nthread*n*passes, timer.seconds());
+  show("slab threads=4", Slab_t::stats());
+
+  bench_done();
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// Each request drops the last reference to a Graph, a node holding a
+//   few thousand shr<Leaf> children.  With deferred reclamation the
+//   releasing thread only queues the Graph, and its destructor (along
+//   with the release of every child) runs on the reclaimer.
+//------------------------------------------------------------
+
+struct Leaf     { long value[4]; };
+struct Graph    { std::vector< shr<Leaf> > leaves; };
+struct DefGraph { std::vector< shr<Leaf> > leaves; };
+
+template <> struct smrt_reclaiming<DefGraph> { typedef smrt_reclaim_deferred Policy_t; };
+
+template <typename G>
+  shr<G> build(unsigned long nleaf)
+  {
+    shr<G> g = make_shr<G>();
+    g->leaves.reserve(nleaf);
+    for(unsigned long i=0; i<nleaf; ++i) g->leaves.push_back( make_shr<Leaf>() );
+    return g;
+  }
+
+// Times only the release of each graph and reports the latency distribution
+
+template <typename G>
+  void run(const std::string &name, unsigned long ngraph, unsigned long nleaf)
+  {
+    std::vector<double> ns(ngraph);
+    double total = 0;
+    for(unsigned long i=0; i<ngraph; ++i)
+    {
+      shr<G> g = build<G>(nleaf);
+      BenchTimer timer;
+      g.release();
+      ns[i]  = timer.seconds() * 1e9;
+      total += ns[i] / 1e9;
+    }
+    smrt_reclaimer::drain();
+
+    std::sort(ns.begin(), ns.end());
+    bench_report(name + " release", ngraph, total);
+    bench_value (name + " p50 ns", ns[ngraph/2]);
+    bench_value (name + " p99 ns", ns[(ngraph*99)/100]);
+    bench_value (name + " max ns", ns[ngraph-1]);
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long ngraph = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 2000UL );
+  unsigned long nleaf  = ( argc>2 ? std::strtoul(argv[2],NULL,10) : 5000UL );
+
+  bench_title("release of the last reference to a graph of " + std::to_string(nleaf) + " nodes");
+  run<Graph>   ("inline           ", ngraph, nleaf);
+
+  smrt_reclaimer::start();
+  run<DefGraph>("deferred (thread)", ngraph, nleaf);
+  smrt_reclaimer::stop();
+
+  run<DefGraph>("deferred (drain) ", ngraph, nleaf);
+
+  smrt_reclaim_stats s = smrt_reclaimer::stats();
+  bench_value("reclaimer high water", s.highWater);
+  bench_value("reclaimer inlined",    s.inlined);
+
+  bench_done();
+  return 0;
+}
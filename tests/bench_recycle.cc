@@ -0,0 +1,74 @@
+#include <vector>
+#include <thread>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+struct Message { long id; long payload[6]; Message(long i=0) : id(i) {} };
+
+//------------------------------------------------------------
+// Each pass creates n messages through one of the factories and then
+//   releases them, as a burst of messages would be.  The handoff run
+//   creates them on one thread and releases them on another, so recycled
+//   blocks must return through the depot.
+//------------------------------------------------------------
+
+struct ByNew      { static shr<Message> make(long i) { return shr<Message>( new Message(i) ); } };
+struct ByMake     { static shr<Message> make(long i) { return make_shr<Message>(i); } };
+struct ByRecycled { static shr<Message> make(long i) { return make_recycled_shr<Message>(i); } };
+
+template <typename F>
+  void run(const std::string &name, unsigned long n, unsigned passes)
+  {
+    std::vector< shr<Message> > live;
+    live.reserve(n);
+
+    BenchTimer timer;
+    for(unsigned pass=0; pass<passes; ++pass)
+    {
+      for(unsigned long i=0; i<n; ++i) live.push_back( F::make(i) );
+      live.clear();
+    }
+    bench_report(name, n*passes, timer.seconds());
+  }
+
+template <typename F>
+  void handoff(const std::string &name, unsigned long n, unsigned passes)
+  {
+    BenchTimer timer;
+    for(unsigned pass=0; pass<passes; ++pass)
+    {
+      std::vector< shr<Message> > batch;
+      batch.reserve(n);
+      for(unsigned long i=0; i<n; ++i) batch.push_back( F::make(i) );
+      std::thread consumer( [&batch]{ batch.clear(); } );
+      consumer.join();
+    }
+    bench_report(name, n*passes, timer.seconds());
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n      = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 1000UL );
+  unsigned      passes = 2000;
+
+  bench_title("create/release bursts of " + std::to_string(n) + " messages x " + std::to_string(passes) + " passes");
+
+  run<ByNew>     ("shr<T>(new T)",        n, passes);
+  run<ByMake>    ("make_shr<T>",          n, passes);
+  run<ByRecycled>("make_recycled_shr<T>", n, passes);
+
+  handoff<ByMake>    ("make_shr<T> freed by another thread",          n, passes/10);
+  handoff<ByRecycled>("make_recycled_shr<T> freed by another thread", n, passes/10);
+
+  shr_recycler_stats s = shr_recycler<Message>::stats();
+  bench_value("recycler hits",     s.hits);
+  bench_value("recycler misses",   s.misses);
+  bench_value("recycler freed",    s.freed);
+  bench_value("recycler hit rate", s.hitRate());
+
+  bench_done();
+  return 0;
+}
@@ -0,0 +1,60 @@
+#include <cstdlib>
+#include <vector>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// Growing a vector of smart pointers one push_back at a time, and erasing
+//   from its middle, with std::vector (which moves each element and
+//   destroys the original) and smrt_vector (realloc and memmove).
+//------------------------------------------------------------
+
+struct Item { long value; };
+
+template <typename V, typename P>
+  void grow(const std::string &name, const std::vector<P> &items, unsigned passes)
+  {
+    BenchTimer timer;
+    for(unsigned pass=0; pass<passes; ++pass)
+    {
+      V v;
+      for(std::size_t i=0; i<items.size(); ++i) v.push_back(items[i]);
+      bench_keep(v[0]);
+    }
+    bench_report(name, items.size()*passes, timer.seconds());
+  }
+
+template <typename V, typename P>
+  void erase(const std::string &name, const std::vector<P> &items, unsigned erases)
+  {
+    V v;
+    for(std::size_t i=0; i<items.size(); ++i) v.push_back(items[i]);
+
+    BenchTimer timer;
+    for(unsigned i=0; i<erases; ++i) v.erase( v.begin() + v.size()/2 );
+    bench_report(name, erases, timer.seconds());
+    bench_keep(v[0]);
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  std::size_t n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 1000000UL );
+
+  std::vector< shr<Item> > items;
+  for(std::size_t i=0; i<n; ++i) items.push_back( new Item() );
+
+  bench_title("push_back of " + std::to_string(n) + " shr<Item> copies without reserve");
+  grow< std::vector< shr<Item> > >("std::vector< shr<Item> >", items, 10);
+  grow< smrt_vector< shr<Item> > >("smrt_vector< shr<Item> >", items, 10);
+  grow< std::vector< const_ref<Item> > >("std::vector< const_ref<Item> >", items, 10);
+  grow< smrt_vector< const_ref<Item> > >("smrt_vector< const_ref<Item> >", items, 10);
+
+  bench_title("\nerase from the middle of " + std::to_string(n) + " shr<Item>");
+  erase< std::vector< shr<Item> > >("std::vector< shr<Item> >::erase", items, 200);
+  erase< smrt_vector< shr<Item> > >("smrt_vector< shr<Item> >::erase", items, 200);
+
+  bench_done();
+  return 0;
+}
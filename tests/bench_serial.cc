@@ -0,0 +1,143 @@
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <unordered_set>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// Writing and reading back n parents, each holding 4 of n/8 shared
+//   items, with smrt_writer/smrt_reader (each item once, the rest as
+//   back references) and naively (each item written in full wherever it
+//   is referred to, and read back as a separate object).
+//------------------------------------------------------------
+
+struct Item
+{
+  std::string payload;
+
+  void smrtWrite(smrt_writer &w) const { w.put(payload); }
+  void smrtRead(smrt_reader &r)        { r.get(payload); }
+};
+
+struct Parent
+{
+  long                      id;
+  std::vector< shr<Item> >  items;
+
+  Parent(void) : id(0) {}
+
+  void smrtWrite(smrt_writer &w) const
+  {
+    w.put(id).putVarint( items.size() );
+    for(std::size_t i=0; i<items.size(); ++i) w.put(items[i]);
+  }
+
+  void smrtRead(smrt_reader &r)
+  {
+    r.get(id);
+    items.resize( r.getVarint() );
+    for(std::size_t i=0; i<items.size(); ++i) r.get(items[i]);
+  }
+};
+
+void naiveWrite(smrt_writer &w, const std::vector< shr<Parent> > &v)
+{
+  w.putVarint( v.size() );
+  for(std::size_t i=0; i<v.size(); ++i)
+  {
+    w.put(v[i]->id).putVarint( v[i]->items.size() );
+    for(std::size_t j=0; j<v[i]->items.size(); ++j) w.put( v[i]->items[j]->payload );
+  }
+}
+
+void naiveRead(smrt_reader &r, std::vector< shr<Parent> > &v)
+{
+  v.resize( r.getVarint() );
+  for(std::size_t i=0; i<v.size(); ++i)
+  {
+    v[i] = make_shr<Parent>();
+    r.get(v[i]->id);
+    v[i]->items.resize( r.getVarint() );
+    for(std::size_t j=0; j<v[i]->items.size(); ++j)
+    {
+      v[i]->items[j] = make_shr<Item>();
+      r.get( v[i]->items[j]->payload );
+    }
+  }
+}
+
+struct Scratch
+{
+  FILE *f;
+  Scratch(void) : f( std::tmpfile() ) {}
+  ~Scratch() { std::fclose(f); }
+  int  fd(void) const { return fileno(f); }
+  void rewind(void)   { lseek(fd(), 0, SEEK_SET); }
+};
+
+template <typename W, typename R>
+  void run(const std::string &label, const std::vector< shr<Parent> > &graph, unsigned long refs, W write, R read)
+  {
+    Scratch file;
+    unsigned long bytes;
+    {
+      BenchTimer  timer;
+      smrt_writer w( file.fd() );
+      write(w, graph);
+      w.flush();
+      bench_report(label + " write (per reference)", refs, timer.seconds());
+      bytes = w.stats().bytes;
+    }
+
+    file.rewind();
+    std::vector< shr<Parent> > copy;
+    {
+      BenchTimer  timer;
+      smrt_reader r( file.fd() );
+      read(r, copy);
+      bench_report(label + " read (per reference)", refs, timer.seconds());
+    }
+
+    std::unordered_set<const Item*> distinct;
+    for(std::size_t i=0; i<copy.size(); ++i)
+      for(std::size_t j=0; j<copy[i]->items.size(); ++j) distinct.insert( copy[i]->items[j].raw() );
+
+    bench_value(label + " bytes", double(bytes));
+    bench_value(label + " items loaded", double(distinct.size()));
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 200000UL );
+  unsigned long m = n/8 + 1;
+
+  bench_title(std::to_string(n) + " parents referring to 4 each of " + std::to_string(m) + " shared items");
+
+  std::vector< shr<Item> > items(m);
+  for(unsigned long i=0; i<m; ++i) { items[i] = make_shr<Item>(); items[i]->payload = std::string(64, char('a' + i%26)); }
+
+  std::vector< shr<Parent> > graph(n);
+  for(unsigned long i=0; i<n; ++i)
+  {
+    graph[i] = make_shr<Parent>();
+    graph[i]->id = long(i);
+    for(int j=0; j<4; ++j) graph[i]->items.push_back( items[ std::rand() % m ] );
+  }
+  unsigned long refs = n*4;
+
+  run("smrt_writer/reader:", graph, refs,
+      [](smrt_writer &w, const std::vector< shr<Parent> > &v) { w.putVarint( v.size() ); for(std::size_t i=0; i<v.size(); ++i) w.put(v[i]); },
+      [](smrt_reader &r, std::vector< shr<Parent> > &v)       { v.resize( r.getVarint() ); for(std::size_t i=0; i<v.size(); ++i) r.get(v[i]); });
+
+  run("naive copies:", graph, refs,
+      [](smrt_writer &w, const std::vector< shr<Parent> > &v) { naiveWrite(w, v); },
+      [](smrt_reader &r, std::vector< shr<Parent> > &v)       { naiveRead(r, v); });
+
+  bench_done();
+  return 0;
+}
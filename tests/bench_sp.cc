@@ -0,0 +1,178 @@
+#include <memory>
+#include <vector>
+#include <set>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// Measures the basic operations of each smart pointer type side by side
+//   with std::unique_ptr and std::shared_ptr:
+//
+//     construct   : wrapping a new object (includes the new)
+//     destroy     : destroying the last pointer (includes the delete)
+//     copy        : copy construction from a live pointer
+//     assign      : copy assignment alternating between two pointers
+//     deref       : operator-> (which includes the NULL check)
+//     refCount    : reading the reference count
+//     vector/set  : the container workloads exercised by test_stl.cc
+//
+//   Usage: bench_sp [--csv|--json] [n]
+//------------------------------------------------------------
+
+struct Obj : public ishr_counted<> { long value; };
+
+struct OwnKind      { typedef own<Obj>                 P; static const char *name(void) { return "own";          } static P make(void) { return P(new Obj);                } };
+struct UniqueKind   { typedef std::unique_ptr<Obj>     P; static const char *name(void) { return "unique_ptr";   } static P make(void) { return P(new Obj);                } };
+struct ShrKind      { typedef shr<Obj>                 P; static const char *name(void) { return "shr";          } static P make(void) { return P(new Obj);                } };
+struct MakeShrKind  { typedef shr<Obj>                 P; static const char *name(void) { return "make_shr";     } static P make(void) { return make_shr<Obj>();           } };
+struct IshrKind     { typedef ishr<Obj>                P; static const char *name(void) { return "ishr";         } static P make(void) { return P(new Obj);                } };
+struct SharedKind   { typedef std::shared_ptr<Obj>     P; static const char *name(void) { return "shared_ptr";   } static P make(void) { return P(new Obj);                } };
+struct MakeSharedKind { typedef std::shared_ptr<Obj>   P; static const char *name(void) { return "make_shared";  } static P make(void) { return std::make_shared<Obj>(); } };
+
+inline unsigned long count_of(const shr<Obj> &p)              { return p.refCount();  }
+inline unsigned long count_of(const ishr<Obj> &p)             { return p.refCount();  }
+inline unsigned long count_of(const std::shared_ptr<Obj> &p)  { return p.use_count(); }
+
+// Construction and destruction are timed separately using raw storage
+
+template <typename K>
+  void lifecycle(unsigned long n)
+  {
+    typedef typename K::P P;
+    P *slots = static_cast<P*>(::operator new(n*sizeof(P)));
+    std::string name = K::name();
+
+    BenchTimer timer;
+    for(unsigned long i=0; i<n; ++i) new(slots+i) P(K::make());
+    bench_report(name + " construct", n, timer.seconds());
+
+    timer.start();
+    for(unsigned long i=0; i<n; ++i) slots[i].~P();
+    bench_report(name + " destroy", n, timer.seconds());
+
+    ::operator delete(slots);
+  }
+
+template <typename P>
+  void copy(const std::string &name, const P &src, unsigned long n)
+  {
+    P *slots = static_cast<P*>(::operator new(n*sizeof(P)));
+
+    BenchTimer timer;
+    for(unsigned long i=0; i<n; ++i) new(slots+i) P(src);
+    bench_report(name + " copy", n, timer.seconds());
+
+    timer.start();
+    for(unsigned long i=0; i<n; ++i) slots[i].~P();
+    bench_report(name + " destroy copy", n, timer.seconds());
+
+    ::operator delete(slots);
+
+    P a = src, b = src, x;
+    timer.start();
+    for(unsigned long i=0; i<n; ++i) { x = ( i&1 ? a : b ); bench_keep(x); }
+    bench_report(name + " assign", n, timer.seconds());
+  }
+
+// The barrier forces the pointer (and its NULL check) to be reloaded each pass
+
+template <typename P>
+  void deref(const std::string &name, const P &p, unsigned long n)
+  {
+    long sum = 0;
+    BenchTimer timer;
+    for(unsigned long i=0; i<n; ++i) { sum += p->value; bench_keep(p); }
+    bench_report(name + " deref", n, timer.seconds());
+    bench_keep(sum);
+  }
+
+template <typename P>
+  void refcount(const std::string &name, const P &p, unsigned long n)
+  {
+    unsigned long sum = 0;
+    BenchTimer timer;
+    for(unsigned long i=0; i<n; ++i) { sum += count_of(p); bench_keep(p); }
+    bench_report(name + " refCount", n, timer.seconds());
+    bench_keep(sum);
+  }
+
+// The vector and set workloads of test_stl.cc: build, append a copy, clear
+
+template <typename K>
+  void containers(unsigned long n)
+  {
+    typedef typename K::P P;
+    std::string name = K::name();
+
+    BenchTimer timer;
+    {
+      std::vector<P> alist, alist2;
+      for(unsigned long i=0; i<n; ++i) alist.push_back( K::make() );
+      for(unsigned long i=0; i<n; ++i) alist2.push_back( K::make() );
+      alist.insert(alist.end(), alist2.begin(), alist2.end());
+      alist.clear();
+      alist2.clear();
+    }
+    bench_report(name + " vector workload", 4*n, timer.seconds());
+
+    timer.start();
+    {
+      std::set<P> alist, alist2;
+      for(unsigned long i=0; i<n; ++i) alist.insert( K::make() );
+      for(unsigned long i=0; i<n; ++i) alist2.insert( K::make() );
+      alist.insert(alist2.begin(), alist2.end());
+      for(typename std::set<P>::iterator x=alist2.begin(); x!=alist2.end(); ++x) bench_keep(alist.find(*x));
+      alist.clear();
+      alist2.clear();
+    }
+    bench_report(name + " set workload", 5*n, timer.seconds());
+  }
+
+template <typename K>
+  void shared(unsigned long n)
+  {
+    lifecycle<K>(n);
+    typename K::P p = K::make();
+    copy(K::name(), p, n);
+    deref(K::name(), p, n);
+    refcount(K::name(), p, n);
+    containers<K>(n/10);
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 1000000UL );
+
+  bench_title("smart pointer operations, n=" + std::to_string(n));
+
+  Obj *raw = new Obj;
+  raw->value = 1;
+  deref("raw", raw, n);
+
+  lifecycle<OwnKind>(n);
+  lifecycle<UniqueKind>(n);
+  {
+    own<Obj>             o = new Obj;
+    std::unique_ptr<Obj> u(new Obj);
+    deref("own", o, n);
+    deref("unique_ptr", u, n);
+
+    ref<Obj> r = o;
+    copy("ref", r, n);
+    deref("ref", r, n);
+  }
+
+  shared<ShrKind>(n);
+  shared<MakeShrKind>(n);
+  shared<IshrKind>(n);
+  shared<SharedKind>(n);
+  shared<MakeSharedKind>(n);
+
+  delete raw;
+
+  bench_done();
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include <vector>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+//------------------------------------------------------------
+// The cost of per type statistics.  This program is built without
+//   SMARTPOINTER_STATS, so only Tracked opts in; Plain compiles to
+//   exactly what it would without the statistics.
+//------------------------------------------------------------
+
+template <int N> struct Obj { long value; };
+
+typedef Obj<0> Plain;
+typedef Obj<1> Tracked;
+
+template <> struct smrt_tracking<Tracked> { static const bool value = true; };
+
+template <typename T>
+  void copies(const std::string &name, unsigned long n)
+  {
+    shr<T> src = make_shr<T>();
+    BenchTimer timer;
+    for(unsigned long i=0; i<n; ++i) { shr<T> x = src; bench_keep(x); }
+    bench_report(name, n, timer.seconds());
+  }
+
+template <typename T>
+  void makes(const std::string &name, unsigned long n)
+  {
+    BenchTimer timer;
+    for(unsigned long i=0; i<n; ++i) { shr<T> x = make_shr<T>(); bench_keep(x); }
+    bench_report(name, n, timer.seconds());
+  }
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 10000000UL );
+
+  bench_title("shr<T> copy and make_shr<T> of " + std::to_string(n) + " objects, with and without statistics");
+
+  copies<Plain>  ("copy and release, untracked", n);
+  copies<Tracked>("copy and release, tracked",   n);
+  makes<Plain>   ("make_shr and release, untracked", n/10);
+  makes<Tracked> ("make_shr and release, tracked",   n/10);
+
+  smrt_type_stats s = smrt_stats<Tracked>::stats();
+  bench_value("tracked incrs", s.incrs);
+  bench_value("tracked peak live", s.peak);
+
+  bench_done();
+  return 0;
+}
@@ -0,0 +1,77 @@
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <cstdlib>
+
+#include "SmartPointers.h"
+#include "bench_common.h"
+
+// Two otherwise identical payloads so that each can use its own counting policy
+
+struct PlainObj  { long value; };
+struct AtomicObj { long value; };
+
+template <> struct shr_counting<AtomicObj> { typedef shr_atomic_count Policy_t; };
+
+//------------------------------------------------------------
+// Each worker repeatedly copies and destroys a shr<T> which shares
+//   ownership with every other worker.  The plain counter is only safe
+//   when every copy and destroy is serialized by a mutex.
+//------------------------------------------------------------
+
+void mutex_worker(const shr<PlainObj> &src, std::mutex &lock, unsigned long n)
+{
+  for(unsigned long i=0; i<n; ++i)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    shr<PlainObj> copy = src;
+    bench_keep(copy);
+  }
+}
+
+void atomic_worker(const shr<AtomicObj> &src, unsigned long n)
+{
+  for(unsigned long i=0; i<n; ++i)
+  {
+    shr<AtomicObj> copy = src;
+    bench_keep(copy);
+  }
+}
+
+int main(int argc,const char **argv)
+{
+  bench_init(argc,argv);
+  unsigned long n = ( argc>1 ? std::strtoul(argv[1],NULL,10) : 2000000UL );
+
+  bench_title("shr<T> copy/destroy throughput, " + std::to_string(n) + " copies per thread");
+
+  for(unsigned nthread=1; nthread<=8; nthread*=2)
+  {
+    {
+      shr<PlainObj> src = new PlainObj;
+      std::mutex    lock;
+      std::vector<std::thread> workers;
+
+      BenchTimer timer;
+      for(unsigned t=0; t<nthread; ++t) workers.push_back(std::thread(mutex_worker, std::cref(src), std::ref(lock), n));
+      for(unsigned t=0; t<nthread; ++t) workers[t].join();
+      double secs = timer.seconds();
+
+      bench_report("mutex+plain  threads=" + std::to_string(nthread), nthread*n, secs);
+    }
+    {
+      shr<AtomicObj> src = new AtomicObj;
+      std::vector<std::thread> workers;
+
+      BenchTimer timer;
+      for(unsigned t=0; t<nthread; ++t) workers.push_back(std::thread(atomic_worker, std::cref(src), n));
+      for(unsigned t=0; t<nthread; ++t) workers[t].join();
+      double secs = timer.seconds();
+
+      bench_report("atomic       threads=" + std::to_string(nthread), nthread*n, secs);
+    }
+  }
+
+  bench_done();
+  return 0;
+}
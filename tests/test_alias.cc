@@ -0,0 +1,82 @@
+#include <iostream>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// A table whose columns are handed out as aliases of the table
+//------------------------------------------------------------
+
+class Table
+{
+  public:
+    Table(void)  { std::cout << "Creating: Table" << std::endl; }
+    ~Table()     { std::cout << "Deleting: Table" << std::endl; }
+
+    A    name;
+    B    index;
+    long column[4];
+};
+
+void alias_tests(void)
+{
+  std::cout << std::endl << "======> alias tests <=======" << std::endl;
+
+  TEST( shr<Table> t = make_shr<Table>() );
+  TEST( shr<A> name( t, &t->name ) );
+  TEST( const_shr<A> index( t, &t->index ) );
+  SHOW_SHR(name);
+  SHOW_SHR(index);
+  TEST( weak_shr<A> w = name );
+  TEST( t.release() );
+  SHOW_SHR(name);
+  TEST( name->func() );
+  TEST( name.release() );
+  TEST( shr<A> locked = w.lock() );
+  SHOW_SHR(locked);
+  TEST( locked.release() );
+  TEST( index.release() );
+  std::cout << "w expired=" << w.isExpired() << std::endl;
+
+  TEST( shr<Table> t2 = make_shr<Table>() );
+  TEST( Table *raw = t2.raw() );
+  TEST( shr<A> moved( std::move(t2), &raw->name ) );
+  std::cout << "t2 isNull=" << t2.isNull() << std::endl;
+  SHOW_SHR(moved);
+  TEST( moved.release() );
+
+  TEST( shr<Table> none );
+  TEST( const_shr<A> n( none, &raw->name ) );
+  SHOW_SHR(n);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void array_alias_tests(void)
+{
+  std::cout << std::endl << "======> array alias tests <=======" << std::endl;
+
+  TEST( shr<Table> t = make_shr<Table>() );
+  TEST( for(int i=0; i<4; ++i) t->column[i] = 10*i );
+  TEST( const_shr<long[]> column( t, t->column, 4 ) );
+  std::cout << "column[3]=" << column[3] << " size=" << column.size() 
+            << " refCount=" << column.refCount() << std::endl;
+
+  TEST( long *column2 = t->column + 2 );
+  TEST( shr<long[]> tail( std::move(t), column2, 2 ) );
+  std::cout << "tail[0]=" << tail[0] << " size=" << tail.size() << " refCount=" << tail.refCount() << std::endl;
+  TEST( const_shr<long> last( tail, &tail[1] ) );
+  std::cout << "*last=" << *last << " refCount=" << last.refCount() << std::endl;
+  TEST( column.release() );
+  TEST( tail.release() );
+  TEST( last.release() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  alias_tests();
+  array_alias_tests();
+
+  return 0;
+}
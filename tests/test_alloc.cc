@@ -0,0 +1,123 @@
+#include <iostream>
+#include <cstdlib>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// A stateless deleter, a stateful deleter, and an allocator which
+//   reports each allocation from (and release to) its named arena
+//------------------------------------------------------------
+
+struct FreeA
+{
+  void operator()(A *p) const { std::cout << "FreeA: "; delete p; }
+};
+
+struct CountingDelete
+{
+  CountingDelete(int *n) : count(n) {}
+  void operator()(A *p) const { *count += 1; std::cout << "CountingDelete #" << *count << ": "; delete p; }
+  int *count;
+};
+
+void free_malloced(A *p) { std::cout << "free_malloced: "; p->~A(); std::free(p); }
+
+template <typename T>
+  struct Arena
+  {
+    typedef T value_type;
+
+    Arena(const char *n) : name(n) {}
+    template <typename U> Arena(const Arena<U> &a) : name(a.name) {}
+
+    T *allocate(std::size_t n)
+    {
+      std::cout << "Arena " << name << ": allocate " << n*sizeof(T) << " bytes" << std::endl;
+      return static_cast<T*>( std::malloc(n*sizeof(T)) );
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+      std::cout << "Arena " << name << ": deallocate " << n*sizeof(T) << " bytes" << std::endl;
+      std::free(p);
+    }
+
+    const char *name;
+  };
+
+template <typename T, typename U> bool operator==(const Arena<T> &a, const Arena<U> &b) { return a.name == b.name; }
+template <typename T, typename U> bool operator!=(const Arena<T> &a, const Arena<U> &b) { return a.name != b.name; }
+
+typedef own<A,FreeA>                                  FreeOwn;
+typedef own<A,CountingDelete>                         CountingOwn;
+typedef own< A, smrt_alloc_delete< A, Arena<A> > >    ArenaOwn;
+typedef own< A, smrt_alloc_delete< A, std::allocator<A> > > StdOwn;
+
+void deleter_tests(void)
+{
+  std::cout << std::endl << "======> custom deleter tests <=======" << std::endl;
+  std::cout << "sizeof(own<A>)=" << sizeof(own<A>) 
+            << " sizeof(FreeOwn)=" << sizeof(FreeOwn)
+            << " sizeof(CountingOwn)=" << sizeof(CountingOwn)
+            << " sizeof(StdOwn)=" << sizeof(StdOwn) << std::endl;
+
+  TEST( FreeOwn o1 = new A );
+  TEST( o1 = new A );
+  TEST( o1.release() );
+
+  TEST( int count = 0 );
+  TEST( CountingOwn o2( new A, CountingDelete(&count) ) );
+  TEST( CountingOwn o3 = std::move(o2) );
+  TEST( o3.release() );
+
+  TEST( A *m = new(std::malloc(sizeof(A))) A );
+  TEST( shr<A> s1( m, &free_malloced ) );
+  TEST( shr<A> s2 = s1 );
+  TEST( weak_shr<A> w = s1 );
+  TEST( s1.release() );
+  TEST( s2.release() );
+  std::cout << "w expired=" << w.isExpired() << std::endl;
+
+  TEST( CountingOwn o4( new A, CountingDelete(&count) ) );
+  TEST( shr<A> s3 = std::move(o4) );
+  SHOW_SHR(s3);
+  TEST( const_shr<A> s4 = FreeOwn(new A) );
+  TEST( s3.release() );
+  TEST( s4.release() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void allocator_tests(void)
+{
+  std::cout << std::endl << "======> allocator tests <=======" << std::endl;
+  TEST( Arena<A> numa0("numa0") );
+  TEST( shr<A> s1 = allocate_shr<A>(numa0) );
+  TEST( const_shr<A> s2 = s1 );
+  SHOW_SHR(s2);
+  TEST( weak_shr<A> w = s1 );
+  TEST( s1.release() );
+  TEST( s2.release() );
+  TEST( w.clear() );
+
+  TEST( const_shr<A> s3 = allocate_const_shr<A>(Arena<char>("request")) );
+  TEST( s3.release() );
+
+  TEST( ArenaOwn o1 = allocate_own<A>(numa0) );
+  TEST( o1->func() );
+  TEST( shr<A> s4 = std::move(o1) );
+  TEST( s4.release() );
+
+  TEST( StdOwn o2 = allocate_own<A>(std::allocator<A>()) );
+  TEST( o2.release() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  deleter_tests();
+  allocator_tests();
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <cstdint>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// Shows the size and reference count of an array smart pointer, along
+//   with the sum of its elements
+//------------------------------------------------------------
+
+#define SHOW_ARRAY(x) \
+  std::cout << std::endl << "show> " #x << ": size=" << x.size() \
+            << " refCount=" << x.refCount() \
+            << " sum=" << sum(x) << std::endl;
+
+// Sums through a view, as a numeric kernel would
+
+long sum(const_ref<long[]> v)
+{
+  long rval = 0;
+  for(const long *x=v.begin(); x!=v.end(); ++x) rval += *x;
+  return rval;
+}
+
+void fill(ref<long[]> v)
+{
+  for(std::size_t i=0; i<v.size(); ++i) v[i] = i+1;
+}
+
+class Thrower
+{
+  public:
+    Thrower(void) { if( ++built == 3 ) throw std::runtime_error("third element"); }
+    ~Thrower() { ++destroyed; }
+
+    static int built;
+    static int destroyed;
+};
+
+int Thrower::built     = 0;
+int Thrower::destroyed = 0;
+
+typedef own< A[], smrt_aligned_delete<A> > AlignedOwn;
+
+void own_tests(void)
+{
+  std::cout << std::endl << "======> own<T[]> tests <=======" << std::endl;
+  std::cout << "sizeof(own<A[]>)=" << sizeof(own<A[]>) 
+            << " sizeof(AlignedOwn)=" << sizeof(AlignedOwn) << std::endl;
+
+  TEST( own<A[]> o1( new A[3], 3 ) );
+  TEST( o1[1].func() );
+  TEST( own<A[]> o2 = std::move(o1) );
+  std::cout << "o1 size=" << o1.size() << " isNull=" << o1.isNull() << std::endl;
+  TEST( o2.release() );
+
+  TEST( AlignedOwn o3 = make_aligned_own<A>(2) );
+  for(A *a=o3.begin(); a!=o3.end(); ++a) a->const_func();
+  TEST( o3.release() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void shr_tests(void)
+{
+  std::cout << std::endl << "======> shr<T[]> tests <=======" << std::endl;
+
+  TEST( shr<long[]> s1 = make_aligned_shr<long>(1000) );
+  TEST( fill(s1) );
+  SHOW_ARRAY(s1);
+  std::cout << "aligned64=" << ( reinterpret_cast<std::uintptr_t>(s1.raw()) % 64 == 0 ) << std::endl;
+  TEST( const_shr<long[]> s2 = s1 );
+  SHOW_ARRAY(s2);
+  TEST( const_ref<long[]> v = s2 );
+  std::cout << "v[999]=" << v[999] << " size=" << v.size() << std::endl;
+  TEST( s1.release() );
+  SHOW_ARRAY(s2);
+  TEST( s2.release() );
+
+  TEST( shr<long[]> s3( new long[4](), 4 ) );
+  TEST( fill(s3) );
+  SHOW_ARRAY(s3);
+
+  TEST( shr<A[]> s4 = own<A[]>( new A[2], 2 ) );
+  TEST( const_shr<A[]> s5 = make_aligned_own<A>(2, 256) );
+  std::cout << "aligned256=" << ( reinterpret_cast<std::uintptr_t>(s5.raw()) % 256 == 0 ) << std::endl;
+  TEST( s5 = s4 );
+  std::cout << "s4 refCount=" << s4.refCount() << std::endl;
+  TEST( s4.release() );
+  TEST( s5.release() );
+
+  long raw[] = { 5, 6, 7 };
+  TEST( const_ref<long[]> r( raw, 3 ) );
+  std::cout << "sum=" << sum(r) << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void error_tests(void)
+{
+  std::cout << std::endl << "======> error tests <=======" << std::endl;
+
+  try                                { make_aligned_own<long>(4, 48); }
+  catch(const std::invalid_argument &e) { std::cout << "invalid_argument: " << e.what() << std::endl; }
+
+  try                                { make_aligned_own<Thrower>(5); }
+  catch(const std::runtime_error &e) { std::cout << "runtime_error: " << e.what() << std::endl; }
+  std::cout << "built=" << Thrower::built << " destroyed=" << Thrower::destroyed << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  own_tests();
+  shr_tests();
+  error_tests();
+
+  return 0;
+}
@@ -0,0 +1,52 @@
+#include <iostream>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+// atomic_shr<T> requires a thread safe counting policy for T
+
+template <> struct shr_counting<A> { typedef shr_atomic_count Policy_t; };
+
+void atomic_shr_tests(void)
+{
+  std::cout << std::endl << "======> atomic_shr<T> tests <=======" << std::endl;
+  TEST( atomic_shr<A> cell );
+  TEST( const_shr<A> a1 = cell.load() );
+  SHOW_SHR(a1);
+
+  TEST( cell.store(new A) );
+  TEST( a1 = cell.load() );
+  SHOW_SHR(a1);
+
+  TEST( const_shr<A> a2 = cell.exchange(make_shr<A>()) );
+  SHOW_SHR(a2);
+  TEST( a1 = cell );
+  SHOW_SHR(a1);
+
+  TEST( const_shr<A> expected = a2 );
+  TEST( bool ok = cell.compareExchange(expected, new A) );
+  std::cout << "ok=" << ok << std::endl;
+  SHOW_SHR(expected);
+
+  TEST( ok = cell.compareExchange(expected, const_shr<A>()) );
+  std::cout << "ok=" << ok << std::endl;
+  TEST( a1 = cell.load() );
+  SHOW_SHR(a1);
+
+  TEST( a2.release() );
+  TEST( expected.release() );
+  TEST( cell = make_shr<A>() );
+  TEST( smrt_hazard::scan() );
+
+  smrt_hazard_stats s = smrt_hazard::stats();
+  std::cout << std::endl << "show> hazard: retired=" << s.retired << " reclaimed=" << s.reclaimed
+            << " pending=" << s.pending << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  atomic_shr_tests();
+
+  return 0;
+}
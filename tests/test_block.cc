@@ -0,0 +1,78 @@
+#include <iostream>
+#include <stdexcept>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// make_shr_block<T>: a batch of objects and their count in one block,
+//   with handles to single elements keeping the whole batch alive
+//------------------------------------------------------------
+
+struct Record
+{
+  long key;
+  long value;
+  Record(long v=0) : key(0), value(v) {}
+};
+
+struct Fragile
+{
+  static int built;
+  Fragile(void)  { if( built == 2 ) throw std::runtime_error("third Fragile"); ++built; std::cout << "Fragile(" << built << ")" << std::endl; }
+  ~Fragile()     { std::cout << "~Fragile(" << built-- << ")" << std::endl; }
+};
+
+int Fragile::built = 0;
+
+void block_tests(void)
+{
+  std::cout << std::endl << "======> make_shr_block<T> tests <=======" << std::endl;
+
+  TEST( shr<A[]> b = make_shr_block<A>(3) );
+  std::cout << "size=" << b.size() << " refCount=" << b.refCount() << std::endl;
+  TEST( shr<A> e = b.element(1) );
+  std::cout << "refCount=" << b.refCount() << " same=" << ( e.raw() == &b[1] ) << std::endl;
+  TEST( const_shr<A> c = b.element(2) );
+  TEST( b.release() );
+  std::cout << "refCount=" << e.refCount() << std::endl;
+  TEST( e->func() );
+  TEST( c->const_func() );
+  TEST( e.release() );
+  TEST( c.release() );
+
+  TEST( const_shr<Record[]> r = make_const_shr_block<Record>(4, 7L) );
+  long sum = 0;
+  for(const Record *i=r.begin(); i!=r.end(); ++i) sum += i->value;
+  std::cout << "sum=" << sum << " contiguous=" << ( &r[3] - &r[0] == 3 ) << std::endl;
+  TEST( const_shr<Record> one = r.element(3) );
+  TEST( r.release() );
+  std::cout << "value=" << one->value << " refCount=" << one.refCount() << std::endl;
+
+  TEST( shr<A[]> none = make_shr_block<A>(0) );
+  std::cout << "isNull=" << none.isNull() << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void failure_tests(void)
+{
+  std::cout << std::endl << "======> make_shr_block<T> failure tests <=======" << std::endl;
+
+  try
+  {
+    TEST( shr<Fragile[]> f = make_shr_block<Fragile>(4) );
+  }
+  catch(const std::exception &e)
+  {
+    std::cout << "caught: " << e.what() << " built=" << Fragile::built << std::endl;
+  }
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  block_tests();
+  failure_tests();
+  return 0;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// shr_copy, shr_release_all and shr_clear over ranges holding many
+//   copies of a few pointers.  The counts must end up exactly as they
+//   would with element by element copies and releases.
+//------------------------------------------------------------
+
+#define SHOW_COUNTS(a,b,c) \
+  std::cout << "refCounts: " << a.refCount() << " " << b.refCount() << " " << c.refCount() << std::endl;
+
+// Writes to a vector, but throws on the write after limit
+
+struct ThrowingOut
+{
+  std::vector< shr<A> > *v;
+  int                    limit;
+
+  ThrowingOut &operator*(void)  { return *this; }
+  ThrowingOut &operator++(void) { return *this; }
+  ThrowingOut &operator=(shr<A> &&p)
+  {
+    if( limit-- == 0 ) throw std::runtime_error("output full");
+    v->push_back(std::move(p));
+    return *this;
+  }
+};
+
+void bulk_tests(void)
+{
+  std::cout << std::endl << "======> shr_copy / shr_release_all tests <=======" << std::endl;
+
+  TEST( shr<A> a = new A );
+  TEST( shr<A> b = new B );
+  TEST( shr<A> c = new A );
+
+  std::vector< shr<A> > src;
+  for(int i=0; i<12; ++i) src.push_back( i%2 ? a : ( i%3 ? b : c ) );
+  src.push_back( shr<A>() );
+  SHOW_COUNTS(a,b,c);
+
+  std::vector< shr<A> > dst;
+  TEST( shr_copy(src.begin(), src.end(), std::back_inserter(dst)) );
+  std::cout << "dst.size=" << dst.size() << " same=" << ( dst[4] == src[4] ) << " last isNull=" << dst.back().isNull() << std::endl;
+  SHOW_COUNTS(a,b,c);
+
+  std::vector< const_shr<A> > cdst;
+  TEST( shr_copy(src.begin(), src.begin()+6, std::back_inserter(cdst)) );
+  SHOW_COUNTS(a,b,c);
+
+  TEST( shr_release_all(dst.begin(), dst.end()) );
+  std::cout << "dst.size=" << dst.size() << " dst[0] isNull=" << dst[0].isNull() << std::endl;
+  SHOW_COUNTS(a,b,c);
+
+  TEST( shr_clear(cdst) );
+  std::cout << "cdst.size=" << cdst.size() << std::endl;
+  SHOW_COUNTS(a,b,c);
+
+  TEST( shr_clear(src) );
+  TEST( a.release() );
+  TEST( b.release() );
+  TEST( c.release() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void failure_tests(void)
+{
+  std::cout << std::endl << "======> shr_copy failure tests <=======" << std::endl;
+
+  TEST( shr<A> a = new A );
+  TEST( shr<A> b = new A );
+  std::vector< shr<A> > src;
+  for(int i=0; i<8; ++i) src.push_back( i%2 ? a : b );
+  std::vector< shr<A> > dst;
+
+  try
+  {
+    ThrowingOut out = { &dst, 5 };
+    TEST( shr_copy(src.begin(), src.end(), out) );
+  }
+  catch(const std::exception &e)
+  {
+    std::cout << "caught: " << e.what() << " dst.size=" << dst.size() << std::endl;
+  }
+  std::cout << "refCounts: " << a.refCount() << " " << b.refCount() << std::endl;
+  TEST( shr_clear(dst) );
+  std::cout << "refCounts: " << a.refCount() << " " << b.refCount() << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void array_tests(void)
+{
+  std::cout << std::endl << "======> shr<T[]> bulk tests <=======" << std::endl;
+
+  TEST( shr<A[]> v = make_shr_block<A>(2) );
+  std::vector< shr<A[]> > src(5, v);
+  std::vector< shr<A[]> > dst;
+  TEST( shr_copy(src.begin(), src.end(), std::back_inserter(dst)) );
+  std::cout << "refCount=" << v.refCount() << " size=" << dst[3].size() << std::endl;
+  TEST( shr_clear(src) );
+  TEST( shr_clear(dst) );
+  std::cout << "refCount=" << v.refCount() << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  bulk_tests();
+  failure_tests();
+  array_tests();
+  return 0;
+}
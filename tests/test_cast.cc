@@ -0,0 +1,111 @@
+#include <iostream>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// Conversions between shared pointers to related types, all of which
+//   must share one count (and so delete the object exactly once)
+//------------------------------------------------------------
+
+struct Tag
+{
+  long tag;
+  Tag(void) : tag(7) {}
+  virtual ~Tag() {}
+};
+
+// A second base, so that the A inside a Tagged is not at its start
+
+struct Tagged : public Tag, public B {};
+
+void upcast_tests(void)
+{
+  std::cout << std::endl << "======> upcast tests <=======" << std::endl;
+
+  TEST( shr<B> b = new B );
+  TEST( shr<A> a = b );
+  SHOW_SHR(a);
+  TEST( const_shr<A> c = b );
+  std::cout << "refCount=" << b.refCount() << std::endl;
+
+  TEST( a = shr<B>(new B) );
+  SHOW_SHR(a);
+  SHOW_SHR(b);
+
+  TEST( shr<A> m = std::move(b) );
+  std::cout << "b isNull=" << b.isNull() << " refCount=" << m.refCount() << std::endl;
+
+  TEST( ref<A> r = m );
+  TEST( r->func() );
+  TEST( const_ref<A> cr = c );
+  TEST( cr->const_func() );
+
+  TEST( shr<Tagged> t = new Tagged );
+  TEST( shr<A> ta = t );
+  std::cout << "adjusted=" << ( (const void*)ta.raw() != (const void*)t.raw() ) << " same=" << ( ta.raw() == t.raw() ) << std::endl;
+  TEST( t.release() );
+  SHOW_SHR(ta);
+  TEST( ta.release() );
+
+  TEST( shr<B> none );
+  TEST( shr<A> nothing = none );
+  SHOW_SHR(nothing);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void cast_tests(void)
+{
+  std::cout << std::endl << "======> static/dynamic/const_shr_cast tests <=======" << std::endl;
+
+  TEST( shr<A> a = new B );
+  TEST( shr<A> plain = new A );
+
+  TEST( shr<B> b = static_shr_cast<B>(a) );
+  TEST( b->func() );
+  std::cout << "refCount=" << a.refCount() << std::endl;
+
+  TEST( shr<B> d = dynamic_shr_cast<B>(a) );
+  std::cout << "isNull=" << d.isNull() << " refCount=" << a.refCount() << std::endl;
+
+  TEST( shr<B> f = dynamic_shr_cast<B>(plain) );
+  std::cout << "isNull=" << f.isNull() << " refCount=" << plain.refCount() << std::endl;
+
+  TEST( shr<B> g = dynamic_shr_cast<B>(std::move(plain)) );
+  std::cout << "isNull=" << g.isNull() << " plain isNull=" << plain.isNull() << std::endl;
+
+  TEST( const_shr<A> c = a );
+  TEST( const_shr<B> cb = dynamic_shr_cast<B>(c) );
+  TEST( cb->const_func() );
+  TEST( shr<B> w = const_shr_cast<B>(cb) );
+  TEST( w->func() );
+  std::cout << "refCount=" << a.refCount() << std::endl;
+
+  TEST( shr<B> moved = static_shr_cast<B>(std::move(a)) );
+  std::cout << "a isNull=" << a.isNull() << " refCount=" << moved.refCount() << std::endl;
+
+  TEST( shr<A> back = const_shr_cast<A>(std::move(c)) );
+  std::cout << "c isNull=" << c.isNull() << " refCount=" << back.refCount() << std::endl;
+
+  TEST( shr<Tagged> t = new Tagged );
+  TEST( shr<Tag> tag = t );
+  TEST( shr<A> across = dynamic_shr_cast<A>(tag) );
+  std::cout << "tag=" << tag->tag << " found=" << ( across.raw() == t.raw() ) << " refCount=" << t.refCount() << std::endl;
+
+  TEST( b.release() );
+  TEST( d.release() );
+  TEST( cb.release() );
+  TEST( w.release() );
+  TEST( back.release() );
+  std::cout << "refCount=" << moved.refCount() << std::endl;
+  TEST( moved.release() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  upcast_tests();
+  cast_tests();
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <stdexcept>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// The NULL checks made when dereferencing.  A has the default policy
+//   (smrt_check_throw), while Unchecked and Asserted select their own.
+//   This program is built with NDEBUG, so the assert compiles away.
+//------------------------------------------------------------
+
+struct Unchecked { long value; };
+struct Asserted  { long value; };
+
+template <> struct smrt_checking<Unchecked> { typedef smrt_check_none   Policy_t; };
+template <> struct smrt_checking<Asserted>  { typedef smrt_check_assert Policy_t; };
+
+#define SHOW_THROW(x) \
+  try { x; std::cout << "no exception" << std::endl; } \
+  catch(const std::runtime_error &e) { std::cout << "caught: " << e.what() << std::endl; }
+
+void throw_tests(void)
+{
+  std::cout << std::endl << "======> default check tests <=======" << std::endl;
+
+  TEST( shr<A> s );
+  TEST( own<A> o );
+  TEST( const_shr<A> c );
+
+  SHOW_THROW( s->func() );
+  SHOW_THROW( (*o).func() );
+  SHOW_THROW( c->const_func() );
+
+  TEST( s = new A );
+  SHOW_THROW( s->func() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void override_tests(void)
+{
+  std::cout << std::endl << "======> per type check tests <=======" << std::endl;
+
+  // Neither checks, so the NULL is handed back rather than thrown
+
+  TEST( shr<Unchecked> u );
+  SHOW_THROW( std::cout << "pointer isNull=" << ( u.operator->() == NULL ) << std::endl );
+
+  TEST( own<Asserted> a );
+  SHOW_THROW( std::cout << "pointer isNull=" << ( a.operator->() == NULL ) << std::endl );
+
+  TEST( u = new Unchecked );
+  TEST( u->value = 5 );
+  std::cout << "value=" << u->value << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  throw_tests();
+  override_tests();
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <set>
+#include <vector>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// Compact shared pointers, with the default count and with a 32-bit one
+//------------------------------------------------------------
+
+#define SHOW_CSHR(x) \
+  std::cout << std::endl << "show> " #x << ": "; \
+  if( x.isNull() ) { std::cout << "NULL"; } \
+  else             { std::cout << *(x); } \
+  std::cout << "  refCount=" << x.refCount() << std::endl;
+
+struct Small { int value; Small(int v) : value(v) {} };
+
+template <> struct cshr_counting<Small> { typedef shr_plain_count32 Policy_t; };
+
+void cshr_tests(void)
+{
+  std::cout << std::endl << "======> cshr<T> tests <=======" << std::endl;
+  std::cout << "sizeof(cshr<A>)=" << sizeof(cshr<A>) << " sizeof(shr<A>)=" << sizeof(shr<A>)
+            << " sizeof(block<A>)=" << sizeof(cshr<A>::Block_t)
+            << " sizeof(block<Small>)=" << sizeof(cshr<Small>::Block_t) << std::endl;
+
+  TEST( cshr<A> c1 = make_cshr<A>() );
+  SHOW_CSHR(c1);
+  TEST( cshr<A> c2 = c1 );
+  TEST( const_cshr<A> c3 = c2 );
+  SHOW_CSHR(c3);
+  TEST( c2->func() );
+  TEST( c3->const_func() );
+  TEST( ref<A> r = c1 );
+  TEST( r->func() );
+  TEST( cshr<A> c4 = std::move(c1) );
+  SHOW_CSHR(c1);
+  SHOW_CSHR(c4);
+  TEST( c2 = make_cshr<A>() );
+  SHOW_CSHR(c2);
+  SHOW_CSHR(c4);
+  TEST( c2 = c2 );
+  SHOW_CSHR(c2);
+  TEST( c2.release() );
+  TEST( c3.release() );
+  TEST( c4.release() );
+
+  TEST( const_cshr<Small> s1 = make_const_cshr<Small>(7) );
+  TEST( const_cshr<Small> s2 = s1 );
+  std::cout << "value=" << s2->value << " refCount=" << s2.refCount() << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void container_tests(void)
+{
+  std::cout << std::endl << "======> cshr<T> container tests <=======" << std::endl;
+
+  TEST( std::vector< cshr<A> > v );
+  TEST( for(int i=0; i<3; ++i) v.push_back( make_cshr<A>() ) );
+  TEST( std::set< cshr<A> > s( v.begin(), v.end() ) );
+  std::cout << "set size=" << s.size() << " refCount=" << v[0].refCount() << std::endl;
+  TEST( s.clear() );
+  TEST( v.clear() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  cshr_tests();
+  container_tests();
+
+  return 0;
+}
@@ -0,0 +1,185 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// Cycles of shr<T> reclaimed by shr_cycles::collect().  Live objects,
+//   including those reachable from a live cycle, must survive.
+//------------------------------------------------------------
+
+struct Node;
+struct Leaf;
+struct Peer;
+
+template <> struct shr_counting<Node> { typedef shr_cycle_count Policy_t; };
+template <> struct shr_counting<Leaf> { typedef shr_cycle_count Policy_t; };
+template <> struct shr_counting<Peer> { typedef shr_cycle_count Policy_t; };
+
+struct Leaf
+{
+  int id;
+  Leaf(int i) : id(i) {}
+  ~Leaf() { std::cout << "~Leaf(" << id << ")" << std::endl; }
+};
+
+struct Node
+{
+  int                       id;
+  shr<Node>                 next;
+  const_shr<Node>           parent;
+  std::vector< shr<Node> >  children;
+  shr<Leaf>                 leaf;
+
+  Node(int i) : id(i) {}
+  ~Node() { std::cout << "~Node(" << id << ")" << std::endl; }
+
+  void shrTrace(shr_tracer &t) const
+  {
+    t(next)(parent)(leaf);
+    for(std::size_t i=0; i<children.size(); ++i) t(children[i]);
+  }
+};
+
+// Its destructor must not be able to revive the rest of its cycle
+
+struct Peer
+{
+  int             id;
+  shr<Peer>       next;
+  weak_shr<Peer>  peer;
+
+  Peer(int i) : id(i) {}
+  ~Peer()
+  {
+    shr<Peer> n = next;
+    std::cout << "~Peer(" << id << ") peer locked=" << ( peer.lock().raw() != NULL ) << std::endl;
+  }
+
+  void shrTrace(shr_tracer &t) const { t(next); }
+};
+
+#define SHOW_STATS \
+  { shr_cycle_stats s = shr_cycles::stats(); \
+    std::cout << "stats> roots=" << s.roots << " collected=" << s.collected << " bytes=" << ( s.bytes > 0 ) << std::endl; }
+
+void ring_tests(void)
+{
+  std::cout << std::endl << "======> shr_cycles ring tests <=======" << std::endl;
+
+  std::size_t n;
+
+  TEST( shr<Node> a = make_shr<Node>(1) );
+  TEST( a->next = make_shr<Node>(2) );
+  TEST( a->next->next = make_shr<Node>(3) );
+  TEST( a->next->next->next = a );
+  TEST( a->leaf = shr<Leaf>( new Leaf(1) ) );
+  std::cout << "refCount=" << a.refCount() << std::endl;
+
+  TEST( weak_shr<Node> w = a );
+  TEST( shr<Node> two = a->next );
+  TEST( a.release() );
+  TEST( n = shr_cycles::collect() );
+  std::cout << "freed=" << n << std::endl;
+  std::cout << "expired=" << w.isExpired() << " refCount=" << two.refCount() << std::endl;
+  SHOW_STATS;
+
+  TEST( two.release() );
+  SHOW_STATS;
+  TEST( n = shr_cycles::collect() );
+  std::cout << "freed=" << n << std::endl;
+  std::cout << "expired=" << w.isExpired() << std::endl;
+  SHOW_STATS;
+
+  TEST( shr<Node> self = make_shr<Node>(4) );
+  TEST( self->next = self );
+  TEST( self.release() );
+  TEST( n = shr_cycles::collect() );
+  std::cout << "freed=" << n << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void tree_tests(void)
+{
+  std::cout << std::endl << "======> shr_cycles tree tests <=======" << std::endl;
+
+  std::size_t n;
+
+  // Children point back at their parent, and one child is held from outside
+
+  TEST( shr<Node> root = make_shr<Node>(10) );
+  for(int i=1; i<=3; ++i)
+  {
+    shr<Node> c = make_shr<Node>(10+i);
+    c->parent = root;
+    root->children.push_back(c);
+  }
+  TEST( shr<Node> kept = root->children[1] );
+  TEST( root.release() );
+  TEST( n = shr_cycles::collect() );
+  std::cout << "freed=" << n << std::endl;
+  std::cout << "kept parent=" << kept->parent->id << " children=" << kept->parent->children.size() << std::endl;
+
+  TEST( kept.release() );
+  TEST( n = shr_cycles::collect() );
+  std::cout << "freed=" << n << std::endl;
+  SHOW_STATS;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void weak_tests(void)
+{
+  std::cout << std::endl << "======> shr_cycles weak tests <=======" << std::endl;
+
+  std::size_t n;
+
+  TEST( shr<Peer> a = make_shr<Peer>(1) );
+  TEST( a->next = make_shr<Peer>(2) );
+  TEST( a->next->next = a );
+  TEST( a->peer = a->next );
+  TEST( a->next->peer = a );
+  TEST( weak_shr<Peer> w = a );
+  TEST( a.release() );
+  TEST( n = shr_cycles::collect() );
+  std::cout << "freed=" << n << " expired=" << w.isExpired() << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void budget_tests(void)
+{
+  std::cout << std::endl << "======> shr_cycles budget tests <=======" << std::endl;
+
+  // Many separate pairs, collected a slice at a time with no budget at all
+
+  for(int i=0; i<300; ++i)
+  {
+    shr<Node> a = make_shr<Node>(1000+i);
+    a->next = make_shr<Node>(2000+i);
+    a->next->next = a;
+  }
+  std::cout << "pending=" << shr_cycles::pending() << std::endl;
+
+  std::cout.setstate(std::ios::failbit);
+  std::size_t freed = 0, calls = 0;
+  while( shr_cycles::pending() > 0 ) { freed += shr_cycles::collect( std::chrono::nanoseconds(0) ); calls += 1; }
+  std::cout.clear();
+
+  shr_cycle_stats s = shr_cycles::stats();
+  std::cout << "freed=" << freed << " calls=" << calls << " pending=" << shr_cycles::pending()
+            << " pauses=" << ( s.maxPauseNs > 0 && s.totalPauseNs >= s.maxPauseNs ) << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  ring_tests();
+  tree_tests();
+  weak_tests();
+  budget_tests();
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+#define SHOW_EPOCH \
+  { \
+    smrt_epoch_stats s = smrt_epoch::stats(); \
+    std::cout << std::endl << "show> epoch: retired=" << s.retired \
+              << " reclaimed=" << s.reclaimed << " pending=" << s.pending << std::endl; \
+  }
+
+#define SHOW_REF(x) \
+  std::cout << std::endl << "show> " #x << ": "; \
+  if( x.isNull() ) { std::cout << "NULL"; } \
+  else             { std::cout << *(x); } \
+  std::cout << std::endl;
+
+// Released B objects are retired to the epoch domain
+
+template <> struct smrt_reclaiming<B> { typedef smrt_reclaim_epoch Policy_t; };
+
+void epoch_own_tests(void)
+{
+  std::cout << std::endl << "======> epoch_own<T> tests <=======" << std::endl;
+  TEST( epoch_own<A> cell = new A );
+  {
+    TEST( smrt_epoch::Guard guard );
+    TEST( const_ref<A> r = cell.load() );
+    TEST( cell.store(new A) );
+    TEST( smrt_epoch::collect() );
+    SHOW_REF(r);
+    SHOW_EPOCH;
+  }
+  TEST( smrt_epoch::synchronize() );
+  SHOW_EPOCH;
+
+  TEST( cell = own<A>(new A) );
+  TEST( cell.release() );
+  TEST( smrt_epoch::synchronize() );
+
+  // Built with SMARTPOINTER_STATS: every A stored was adopted and disposed of
+
+  std::cout << std::endl << "stats> ";
+  smrt_stats<A>::dump(std::cout);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void retire_tests(void)
+{
+  std::cout << std::endl << "======> retire tests <=======" << std::endl;
+  TEST( shr<A> s1 = new A );
+  TEST( own<A> o1 = new A );
+  {
+    TEST( smrt_epoch::Guard guard );
+    TEST( const_ref<A> r1 = s1 );
+    TEST( const_ref<A> r2 = o1 );
+    TEST( smrt_epoch::retire(std::move(s1)) );
+    TEST( smrt_epoch::retire(std::move(o1)) );
+    TEST( smrt_epoch::collect() );
+    SHOW_REF(r1);
+    SHOW_REF(r2);
+  }
+  TEST( smrt_epoch::synchronize() );
+  SHOW_EPOCH;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void policy_tests(void)
+{
+  std::cout << std::endl << "======> smrt_reclaim_epoch tests <=======" << std::endl;
+  TEST( shr<B> s1 = new B );
+  {
+    TEST( smrt_epoch::Guard guard );
+    TEST( const_ref<B> r = s1 );
+    TEST( s1.release() );
+    TEST( smrt_epoch::collect() );
+    SHOW_REF(r);
+  }
+  TEST( smrt_epoch::synchronize() );
+  SHOW_EPOCH;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  epoch_own_tests();
+  retire_tests();
+  policy_tests();
+
+  return 0;
+}
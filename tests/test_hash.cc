@@ -0,0 +1,134 @@
+#include <iostream>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// Hashed and ordered containers of smart pointers, probed with raw
+//   pointers.  None of the lookups below may adopt (and so delete) the
+//   object they are given.  Built both with the default standard
+//   (test_hash) and with -std=c++20 (test_hash20): the unordered
+//   containers only take a raw key from C++20, so below it they are
+//   probed with the smart pointers already held.
+//------------------------------------------------------------
+
+struct Counted : public ishr_counted<>
+{
+  int value;
+  Counted(int v) : value(v) {}
+};
+
+void set_tests(void)
+{
+  std::cout << std::endl << "======> std::set tests <=======" << std::endl;
+
+  TEST( std::set< shr<A> > s );
+  TEST( shr<A> a1 = new A );
+  TEST( shr<A> a2 = new B );
+  TEST( A *r = new A );
+  TEST( s.insert(a1) );
+  TEST( s.insert(a2) );
+  std::cout << "refCount=" << a1.refCount() << std::endl;
+
+  TEST( bool found = s.find(a1.raw()) != s.end() );
+  std::cout << "found=" << found << " refCount=" << a1.refCount() << std::endl;
+  TEST( found = s.count(r) != 0 );
+  std::cout << "found=" << found << std::endl;
+  TEST( found = s.find(const_shr<A>(a2)) != s.end() );
+  std::cout << "found=" << found << std::endl;
+  TEST( delete r );
+
+  typedef std::map< const_shr<A>, int, smrt_less > Map_t;
+  TEST( Map_t m );
+  TEST( m[a1] = 1 );
+  TEST( m[a2] = 2 );
+  std::cout << "m[a2.raw()]=" << m.find(a2.raw())->second << std::endl;
+  TEST( s.clear() );
+  TEST( m.clear() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void unordered_tests(void)
+{
+  std::cout << std::endl << "======> std::unordered_set tests <=======" << std::endl;
+
+  TEST( std::unordered_set< shr<A> > s );
+  TEST( shr<A> a1 = new A );
+  TEST( shr<A> a2 = new B );
+  TEST( A *r = new A );
+  TEST( s.insert(a1) );
+  TEST( s.insert(a2) );
+  std::cout << "hash equal=" << ( std::hash< shr<A> >()(a1) == smrt_hash()(a1.raw()) ) << std::endl;
+
+  typedef std::unordered_map< const_ref<A>, int > Map_t;
+  TEST( Map_t m );
+  TEST( m[a1] = 1 );
+
+#if __cplusplus >= 202002L
+  TEST( bool found = s.find(a2.raw()) != s.end() );
+  std::cout << "found=" << found << " refCount=" << a2.refCount() << std::endl;
+  TEST( found = s.contains(r) );
+  std::cout << "found=" << found << std::endl;
+  TEST( delete r );
+
+  TEST( std::unordered_set< own<A> > o );
+  TEST( A *p = new A );
+  TEST( o.insert( own<A>(p) ) );
+  TEST( found = o.find(p) != o.end() );
+  std::cout << "found=" << found << std::endl;
+  TEST( o.erase( o.find(p) ) );
+
+  std::cout << "m[a1.raw()]=" << m.find(a1.raw())->second << std::endl;
+#else
+  // Below C++20 find() takes only a key, so a raw pointer would be
+  //   adopted by a temporary shr<A>.  Probe with the pointers held instead.
+
+  TEST( bool found = s.find(a2) != s.end() );
+  std::cout << "found=" << found << " refCount=" << a2.refCount() << std::endl;
+  TEST( found = s.count( shr<A>() ) != 0 );
+  std::cout << "found=" << found << std::endl;
+  TEST( delete r );
+
+  TEST( found = m.find( const_ref<A>(a1) ) != m.end() );
+  std::cout << "found=" << found << " refCount=" << a1.refCount() << std::endl;
+  std::cout << "m[a1]=" << m.find(a1)->second << std::endl;
+#endif
+
+  TEST( std::unordered_set< ishr<Counted> > c );
+  TEST( Counted *k = new Counted(3) );
+  TEST( c.insert(k) );
+  std::cout << "count=" << ishr_count(k) << std::endl;
+#if __cplusplus >= 202002L
+  TEST( found = c.find(k) != c.end() );
+#else
+  TEST( found = c.find( *c.begin() ) != c.end() );
+#endif
+  std::cout << "found=" << found << " count=" << ishr_count(k) << std::endl;
+
+  TEST( std::unordered_set< shr<A[]> > arrays );
+  TEST( shr<A[]> v = make_aligned_shr<A>(2) );
+  TEST( arrays.insert(v) );
+#if __cplusplus >= 202002L
+  TEST( found = arrays.find(&v[0]) != arrays.end() );
+#else
+  TEST( found = arrays.find(v) != arrays.end() );
+#endif
+  std::cout << "found=" << found << " refCount=" << v.refCount() << std::endl;
+
+  TEST( s.clear() );
+  TEST( m.clear() );
+  TEST( arrays.clear() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  set_tests();
+  unordered_tests();
+  return 0;
+}
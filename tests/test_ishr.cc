@@ -0,0 +1,107 @@
+#include <iostream>
+#include <vector>
+#include <set>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+// Uses the ishr_counted base class to hold the count
+
+class I : public A, public ishr_counted<> 
+{
+  public:
+    void self(void) { ishr<I> me = this; std::cout << "self: refCount=" << me.refCount() << std::endl; }
+};
+
+// Supplies its own count through the customization functions
+
+struct J
+{
+  J(void) : count(0) { std::cout << "Creating: J" << std::endl; }
+  ~J() { std::cout << "Deleting: J" << std::endl; }
+  mutable int count;
+};
+
+void          ishr_incr(const J *p)  { p->count += 1; }
+bool          ishr_decr(const J *p)  { return --p->count == 0; }
+unsigned long ishr_count(const J *p) { return p->count; }
+
+std::ostream &operator<<(std::ostream &s, const J &x) { s << "J"; return s; }
+
+void const_ishr_tests(void)
+{
+  std::cout << std::endl << "======> const_ishr<T> tests <=======" << std::endl;
+  TEST( std::cout << "sizeof(const_ishr<I>)=" << sizeof(const_ishr<I>) << "  sizeof(I*)=" << sizeof(I*) << std::endl );
+  TEST( const_ishr<I> a1 = new I );
+  TEST( const_ishr<I> a2 = a1 );
+  TEST( const_ishr<I> a3 );
+  SHOW_SHR(a1);
+  SHOW_SHR(a3);
+  TEST( a1->const_func() );
+
+  // unlike shr<T>, the same raw pointer may be given to several ishr<T>
+  TEST( const_ishr<I> a4 = a1.raw() );
+  SHOW_SHR(a4);
+
+  TEST( a1.release() );
+  TEST( a2 = new I );
+  SHOW_SHR(a4);
+  TEST( a4 = a4 );
+  TEST( a4.release() );
+  SHOW_SHR(a2);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void ishr_tests(void)
+{
+  std::cout << std::endl << "======> ishr<T> tests <=======" << std::endl;
+  TEST( ishr<I> a1 = new I );
+  TEST( ishr<I> a2 = a1 );
+  TEST( const_ishr<I> ca1 = a1 );
+  SHOW_SHR(a1);
+  TEST( a1->func() );
+  TEST( a1->self() );
+
+  TEST( ishr<I> a3 = std::move(a2) );
+  SHOW_SHR(a2);
+  SHOW_SHR(a3);
+
+  TEST( ref<I> r1 = a1 );
+  TEST( const_ref<I> cr1 = ca1 );
+  TEST( r1->func() );
+  TEST( if(r1==a1 && cr1.isSet()) std::cout << "  OK" << std::endl; else std::cout << "NOPE" << std::endl );
+
+  TEST( ishr<J> j1 = new J );
+  TEST( ishr<J> j2 = j1 );
+  SHOW_SHR(j1);
+  TEST( j1.release() );
+  TEST( j2.release() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void ishr_stl_tests(void)
+{
+  std::cout << std::endl << "======> ishr<T> stl tests <=======" << std::endl;
+  TEST( std::vector< ishr<I> > ilist );
+  TEST( std::set< ishr<I> > iset );
+  TEST( ilist.push_back( new I ) );
+  TEST( ilist.push_back( new I ) );
+  TEST( ilist.push_back( ilist[0] ) );
+  TEST( iset.insert( ilist.begin(), ilist.end() ) );
+  TEST( std::cout << "ilist=" << ilist.size() << " iset=" << iset.size() << std::endl );
+  SHOW_SHR(ilist[0]);
+  TEST( ilist.clear() );
+  TEST( iset.clear() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  const_ishr_tests();
+  ishr_tests();
+  ishr_stl_tests();
+
+  return 0;
+}
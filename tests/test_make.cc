@@ -0,0 +1,69 @@
+#include <iostream>
+#include <vector>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+class C : public A
+{
+  public:
+    C(int x, const char *label) : _x(x), _label(label) {}
+
+    void show(void) const { std::cout << "C(" << _x << "," << _label << ")" << std::endl; }
+
+  private:
+    int         _x;
+    const char *_label;
+};
+
+void make_shr_tests(void)
+{
+  std::cout << std::endl << "======> make_shr<T> tests <=======" << std::endl;
+  TEST( shr<A> a1 = make_shr<A>() );
+  TEST( shr<B> b1 = make_shr<B>() );
+  TEST( shr<C> c1 = make_shr<C>(7,"seven") );
+  TEST( const_shr<A> ca1 = make_const_shr<A>() );
+  TEST( const_shr<C> cc1 = make_const_shr<C>(8,"eight") );
+
+  SHOW_SHR(a1);
+  SHOW_SHR(b1);
+  TEST( c1->show() );
+  TEST( cc1->show() );
+
+  TEST( shr<A> a2 = a1 );
+  TEST( const_shr<A> ca2 = a1 );
+  SHOW_SHR(a1);
+  TEST( a1->func() );
+  TEST( ca1->const_func() );
+
+  TEST( a2 = make_shr<A>() );
+  SHOW_SHR(a1);
+  SHOW_SHR(a2);
+  TEST( a1.release() );
+  SHOW_SHR(ca2);
+  TEST( ca2.release() );
+  TEST( ca1 = ca1 );
+  SHOW_SHR(ca1);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void make_shr_stl_tests(void)
+{
+  std::cout << std::endl << "======> make_shr<T> stl tests <=======" << std::endl;
+  TEST( std::vector< shr<A> > alist );
+  TEST( alist.push_back( make_shr<A>() ) );
+  TEST( alist.push_back( make_shr<A>() ) );
+  TEST( alist.push_back( alist[0] ) );
+  SHOW_SHR(alist[0]);
+  TEST( alist.clear() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  make_shr_tests();
+  make_shr_stl_tests();
+
+  return 0;
+}
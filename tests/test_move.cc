@@ -0,0 +1,92 @@
+#include <iostream>
+#include <vector>
+#include <utility>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+own<A> make_own_A(void) { own<A> a = new A; return a; }
+shr<A> make_shr_A(void) { shr<A> a = new A; return a; }
+
+void own_move_tests(void)
+{
+  std::cout << std::endl << "======> own<T> move tests <=======" << std::endl;
+  TEST( own<A> a1 = new A );
+  TEST( own<A> a2 = std::move(a1) );
+  TEST( std::cout << (a1.isNull() ? "a1 NULL" : "a1 SET") << "  " << *a2 << std::endl );
+
+  TEST( own<A> a3 = new B );
+  TEST( a3 = std::move(a2) );
+  TEST( std::cout << (a2.isNull() ? "a2 NULL" : "a2 SET") << "  " << *a3 << std::endl );
+
+  TEST( const_own<A> ca1 = std::move(a3) );
+  TEST( ca1->const_func() );
+
+  TEST( own<A> a4 = make_own_A() );
+  TEST( a4->func() );
+
+  TEST( std::vector< own<A> > alist );
+  TEST( alist.push_back( own<A>(new A) ) );
+  TEST( alist.push_back( std::move(a4) ) );
+  TEST( alist.push_back( make_own_A() ) );
+  TEST( alist.erase( alist.begin() ) );
+  TEST( alist.clear() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void shr_move_tests(void)
+{
+  std::cout << std::endl << "======> shr<T> move tests <=======" << std::endl;
+  TEST( shr<A> a1 = new A );
+  TEST( shr<A> a2 = a1 );
+  SHOW_SHR(a1);
+  TEST( shr<A> a3 = std::move(a1) );
+  SHOW_SHR(a1);
+  SHOW_SHR(a3);
+
+  TEST( const_shr<A> ca1 = std::move(a3) );
+  SHOW_SHR(a3);
+  SHOW_SHR(ca1);
+
+  TEST( a2 = make_shr_A() );
+  SHOW_SHR(ca1);
+  SHOW_SHR(a2);
+
+  TEST( ca1 = std::move(ca1) );
+  SHOW_SHR(ca1);
+  TEST( ca1 = std::move(a2) );
+  SHOW_SHR(ca1);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void own_to_shr_tests(void)
+{
+  std::cout << std::endl << "======> own<T> to shr<T> tests <=======" << std::endl;
+  TEST( own<A> o1 = new A );
+  TEST( own<A> o2 = new B );
+  TEST( const_own<A> co1 = new A );
+
+  TEST( shr<A> s1 = std::move(o1) );
+  TEST( std::cout << (o1.isNull() ? "o1 NULL" : "o1 SET") << std::endl );
+  SHOW_SHR(s1);
+
+  TEST( s1 = std::move(o2) );
+  SHOW_SHR(s1);
+
+  TEST( const_shr<A> cs1 = std::move(co1) );
+  SHOW_SHR(cs1);
+  TEST( cs1 = make_own_A() );
+  SHOW_SHR(cs1);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  own_move_tests();
+  shr_move_tests();
+  own_to_shr_tests();
+
+  return 0;
+}
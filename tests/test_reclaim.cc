@@ -0,0 +1,116 @@
+#include <iostream>
+#include <vector>
+
+#define SMARTPOINTER_DEFERRED_DELETE
+#define SMARTPOINTER_RECLAIM_CAPACITY 4
+#include "SmartPointers.h"
+#include "test_common.h"
+
+#define SHOW_RECLAIM \
+  { \
+    smrt_reclaim_stats s = smrt_reclaimer::stats(); \
+    std::cout << std::endl << "show> reclaimer: depth=" << s.depth \
+              << " highWater=" << s.highWater << " deferred=" << s.deferred \
+              << " inlined=" << s.inlined << " reclaimed=" << s.reclaimed \
+              << " running=" << s.running << std::endl; \
+  }
+
+// Holds a shr<A> so that deleting one object releases another
+
+struct Holder
+{
+  Holder(const shr<A> &a) : _a(a) { std::cout << "Creating: Holder" << std::endl; }
+  ~Holder() { std::cout << "Deleting: Holder" << std::endl; }
+  shr<A> _a;
+};
+
+// Deleted at once despite SMARTPOINTER_DEFERRED_DELETE
+
+template <> struct smrt_reclaiming<B> { typedef smrt_reclaim_now Policy_t; };
+
+void drain_tests(void)
+{
+  std::cout << std::endl << "======> drain on demand tests <=======" << std::endl;
+  TEST( own<A> o1 = new A );
+  TEST( shr<A> s1 = new A );
+  TEST( shr<A> s2 = s1 );
+  TEST( shr<A> s3 = make_shr<A>() );
+  TEST( own<B> o2 = new B );
+
+  TEST( o1.release() );
+  TEST( s1.release() );
+  TEST( s2 = s3 );
+  TEST( s3.release() );
+  TEST( o2.release() );
+  SHOW_RECLAIM;
+
+  TEST( smrt_reclaimer::drain() );
+  SHOW_RECLAIM;
+
+  TEST( weak_shr<A> w = s2 );
+  TEST( s2.release() );
+  std::cout << std::endl << "show> w: " << ( w.isExpired() ? "EXPIRED" : "ALIVE" ) << std::endl;
+  TEST( smrt_reclaimer::drain(1) );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void chain_tests(void)
+{
+  std::cout << std::endl << "======> chained release tests <=======" << std::endl;
+  TEST( own<Holder> h = new Holder(new A) );
+  TEST( h.release() );
+  SHOW_RECLAIM;
+  TEST( smrt_reclaimer::drain() );
+  SHOW_RECLAIM;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void overflow_tests(void)
+{
+  std::cout << std::endl << "======> full queue tests <=======" << std::endl;
+  TEST( std::vector< shr<A> > v(6) );
+  for(size_t i=0; i<v.size(); ++i) v[i] = new A;
+  TEST( v.clear() );
+  SHOW_RECLAIM;
+  TEST( smrt_reclaimer::drain() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+// Deleted by the background thread, so it only counts its deletions (and
+//   they are shown once stop() has drained the queue)
+
+struct Quiet
+{
+  static std::atomic<int> deleted;
+  ~Quiet() { deleted += 1; }
+};
+
+std::atomic<int> Quiet::deleted(0);
+
+void thread_tests(void)
+{
+  std::cout << std::endl << "======> background thread tests <=======" << std::endl;
+  TEST( smrt_reclaimer::start() );
+  TEST( shr<Quiet> s1 = new Quiet );
+  TEST( own<Quiet> o1 = new Quiet );
+  TEST( s1.release() );
+  TEST( o1.release() );
+  TEST( smrt_reclaimer::stop() );
+  std::cout << std::endl << "show> Quiet deleted=" << Quiet::deleted << std::endl;
+  SHOW_RECLAIM;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  drain_tests();
+  chain_tests();
+  overflow_tests();
+  thread_tests();
+
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// make_recycled_shr<T>: blocks reused on one thread, limits, trimming,
+//   weak references, and blocks freed by another thread coming back
+//   through the depot.
+//------------------------------------------------------------
+
+struct Message
+{
+  int id;
+  Message(int i) : id(i) {}
+};
+
+void show(const char *label)
+{
+  shr_recycler_stats s = shr_recycler<A>::stats();
+  std::cout << label << ": hits=" << s.hits << " misses=" << s.misses << " recycled=" << s.recycled
+            << " freed=" << s.freed << " cached=" << s.cached << " hitRate=" << s.hitRate() << std::endl;
+}
+
+void recycle_tests(void)
+{
+  std::cout << std::endl << "======> make_recycled_shr<T> tests <=======" << std::endl;
+
+  TEST( shr<A> a1 = make_recycled_shr<A>() );
+  TEST( const void *first = a1.raw() );
+  TEST( a1.release() );
+  show("after one");
+
+  TEST( const_shr<A> a2 = make_recycled_const_shr<A>() );
+  std::cout << "same block=" << ( a2.raw() == first ) << std::endl;
+  TEST( a2->const_func() );
+  show("after reuse");
+
+  TEST( shr<A> a3 = make_recycled_shr<A>() );
+  TEST( weak_shr<A> w = a3 );
+  TEST( a3.release() );
+  show("while weak");
+  TEST( w.clear() );
+  show("after weak");
+
+  TEST( a2.release() );
+  TEST( shr_recycler<A>::trim() );
+  show("after trim");
+
+  TEST( shr_recycler<A>::limit(1, 1) );
+  TEST( shr<A> b1 = make_recycled_shr<A>() );
+  TEST( shr<A> b2 = make_recycled_shr<A>() );
+  TEST( shr<A> b3 = make_recycled_shr<A>() );
+  TEST( b1.release() );
+  TEST( b2.release() );
+  TEST( b3.release() );
+  show("limited");
+  std::cout << "threadLimit=" << shr_recycler<A>::stats().threadLimit
+            << " sharedLimit=" << shr_recycler<A>::stats().sharedLimit << std::endl;
+  TEST( shr_recycler<A>::trim() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void thread_tests(void)
+{
+  std::cout << std::endl << "======> cross thread tests <=======" << std::endl;
+
+  std::vector< shr<Message> > v;
+  for(int i=0; i<1000; ++i) v.push_back( make_recycled_shr<Message>(i) );
+
+  std::thread consumer( [&v]{ long sum = 0; for(size_t i=0; i<v.size(); ++i) sum += v[i]->id; v.clear(); std::cout << "consumer sum=" << sum << std::endl; } );
+  consumer.join();
+
+  shr_recycler_stats s = shr_recycler<Message>::stats();
+  std::cout << "after consumer: misses=" << s.misses << " recycled=" << s.recycled << " cached=" << s.cached << std::endl;
+
+  for(int i=0; i<1000; ++i) v.push_back( make_recycled_shr<Message>(i) );
+  s = shr_recycler<Message>::stats();
+  std::cout << "after refill: hits=" << s.hits << " misses=" << s.misses << " cached=" << s.cached << std::endl;
+  v.clear();
+  shr_recycler<Message>::trim();
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  recycle_tests();
+  thread_tests();
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <string>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// smrt_vector<T> growing and erasing with trivially relocatable smart
+//   pointers (realloc/memmove, no count is touched) and with a type which
+//   records its own address (moved one element at a time).
+//------------------------------------------------------------
+
+struct Anchored
+{
+  int       value;
+  Anchored *self;
+
+  Anchored(int v)                : value(v),       self(this) {}
+  Anchored(const Anchored &a)    : value(a.value), self(this) {}
+  Anchored &operator=(const Anchored &a) { value = a.value; return *this; }
+
+  bool ok(void) const { return self == this; }
+};
+
+void trait_tests(void)
+{
+  std::cout << std::endl << "======> smrt_relocatable<T> tests <=======" << std::endl;
+  std::cout << "shr<A>="          << smrt_relocatable< shr<A> >::value
+            << " const_shr<A>="   << smrt_relocatable< const_shr<A> >::value
+            << " own<A>="         << smrt_relocatable< own<A> >::value
+            << " own<A[]>="       << smrt_relocatable< own<A[]> >::value
+            << " ishr<A>="        << smrt_relocatable< ishr<A> >::value
+            << " cshr<A>="        << smrt_relocatable< cshr<A> >::value
+            << " ref<A>="         << smrt_relocatable< ref<A> >::value
+            << " weak_shr<A>="    << smrt_relocatable< weak_shr<A> >::value
+            << " int="            << smrt_relocatable< int >::value
+            << " std::string="    << smrt_relocatable< std::string >::value
+            << " Anchored="       << smrt_relocatable< Anchored >::value << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void shr_tests(void)
+{
+  std::cout << std::endl << "======> smrt_vector< shr<A> > tests <=======" << std::endl;
+
+  TEST( smrt_vector< shr<A> > v );
+  TEST( shr<A> a = new A );
+  TEST( for(int i=0; i<31; ++i) v.push_back(a) );
+  std::cout << "size=" << v.size() << " capacity=" << v.capacity() << " refCount=" << a.refCount() << std::endl;
+
+  TEST( v.push_back( new B ) );
+  TEST( v.emplace_back( v[31] ) );
+  std::cout << "size=" << v.size() << " capacity=" << v.capacity() << " refCount=" << v.back().refCount() << std::endl;
+
+  TEST( v.erase( v.begin() + 3 ) );
+  TEST( v.erase( v.begin() + 31 ) );
+  std::cout << "size=" << v.size() << " refCount=" << a.refCount() << " back refCount=" << v.back().refCount() << std::endl;
+
+  TEST( smrt_vector< shr<A> > w = v );
+  std::cout << "refCount=" << a.refCount() << std::endl;
+  TEST( smrt_vector< shr<A> > x = std::move(w) );
+  std::cout << "w.size=" << w.size() << " x.size=" << x.size() << " refCount=" << a.refCount() << std::endl;
+  TEST( x.clear() );
+  std::cout << "refCount=" << a.refCount() << std::endl;
+  TEST( v.pop_back() );
+  std::cout << "size=" << v.size() << std::endl;
+  TEST( v = smrt_vector< shr<A> >() );
+  std::cout << "refCount=" << a.refCount() << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void own_tests(void)
+{
+  std::cout << std::endl << "======> smrt_vector< own<A> > tests <=======" << std::endl;
+
+  TEST( smrt_vector< own<A> > v );
+  TEST( for(int i=0; i<10; ++i) v.emplace_back( new A ) );
+  std::cout << "size=" << v.size() << " capacity=" << v.capacity() << std::endl;
+  TEST( v.erase( v.begin() ) );
+  TEST( v[0]->const_func() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void anchored_tests(void)
+{
+  std::cout << std::endl << "======> smrt_vector<Anchored> tests <=======" << std::endl;
+
+  TEST( smrt_vector<Anchored> v );
+  TEST( for(int i=0; i<16; ++i) v.emplace_back(i) );
+  TEST( v.push_back( v[15] ) );
+  std::cout << "size=" << v.size() << " capacity=" << v.capacity() << std::endl;
+  TEST( v.erase( v.begin() + 5 ) );
+
+  bool ok  = true;
+  int  sum = 0;
+  for(smrt_vector<Anchored>::iterator i=v.begin(); i!=v.end(); ++i) { ok = ok && i->ok(); sum += i->value; }
+  std::cout << "size=" << v.size() << " ok=" << ok << " sum=" << sum << std::endl;
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  trait_tests();
+  shr_tests();
+  own_tests();
+  anchored_tests();
+  return 0;
+}
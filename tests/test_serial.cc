@@ -0,0 +1,384 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <unistd.h>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// Object graphs written by smrt_writer and read back by smrt_reader.
+//   Objects shared before writing must come back shared, once each.
+//------------------------------------------------------------
+
+struct Item
+{
+  std::string name;
+  Item(void) {}
+  Item(const std::string &n) : name(n) {}
+  ~Item() { std::cout << "~Item(" << name << ")" << std::endl; }
+
+  void smrtWrite(smrt_writer &w) const { w.put(name); }
+  void smrtRead(smrt_reader &r)        { r.get(name); }
+};
+
+struct Node
+{
+  int                       id;
+  shr<Node>                 next;
+  const_shr<Node>           parent;
+  std::vector< shr<Node> >  children;
+  shr<Item>                 item;
+  own<Item>                 label;
+
+  Node(void) : id(0) {}
+  Node(int i) : id(i) {}
+  ~Node() { std::cout << "~Node(" << id << ")" << std::endl; }
+
+  void smrtWrite(smrt_writer &w) const
+  {
+    w.put(id).put(next).put(parent).put(item).put(label);
+    w.putVarint( children.size() );
+    for(std::size_t i=0; i<children.size(); ++i) w.put(children[i]);
+  }
+
+  void smrtRead(smrt_reader &r)
+  {
+    r.get(id).get(next).get(parent).get(item).get(label);
+    children.resize( r.getVarint() );
+    for(std::size_t i=0; i<children.size(); ++i) r.get(children[i]);
+  }
+};
+
+// Raw pointers are trivially copyable, but put() and get() refuse them
+//   (w.put(&id) fails to compile with a message)
+
+static_assert( smrt_serial::isValue<int>::value,            "an int is written as a value" );
+static_assert( ! smrt_serial::isValue<Item*>::value,       "a raw pointer is not written as a value" );
+static_assert( ! smrt_serial::isValue<int Node::*>::value, "a member pointer is not written as a value" );
+
+// A temporary file, rewound for reading once written
+
+struct Scratch
+{
+  FILE *f;
+  Scratch(void) : f( std::tmpfile() ) {}
+  ~Scratch() { std::fclose(f); }
+  int  fd(void) const { return fileno(f); }
+  void rewind(void)   { lseek(fd(), 0, SEEK_SET); }
+};
+
+#define SHOW_STATS(x) \
+  { smrt_serial_stats s = (x).stats(); \
+    std::cout << "stats> objects=" << s.objects << " shared=" << s.shared << " backrefs=" << s.backrefs << std::endl; }
+
+void graph_tests(void)
+{
+  std::cout << std::endl << "======> smrt_writer/smrt_reader graph tests <=======" << std::endl;
+
+  Scratch file;
+
+  // A root with three children pointing back at it, all sharing one item,
+  //   and the last child's chain leading back to the first child
+
+  {
+    TEST( shr<Item> common = make_shr<Item>("common") );
+    TEST( shr<Node> root = make_shr<Node>(1) );
+    for(int i=2; i<=4; ++i)
+    {
+      shr<Node> c = make_shr<Node>(i);
+      c->parent = root;
+      c->item   = common;
+      root->children.push_back(c);
+    }
+    TEST( root->children[2]->next = make_shr<Node>(5) );
+    TEST( root->children[2]->next->next = root->children[0] );
+    TEST( root->label = new Item("label") );
+    TEST( root->item = make_shr<Item>("alone") );
+
+    TEST( smrt_writer w( file.fd() ) );
+    TEST( w.put(root).put( std::string("end") ).put(common) );
+    TEST( w.flush() );
+    SHOW_STATS(w);
+
+    // The cycles through parent and next must be broken by hand
+
+    for(std::size_t i=0; i<root->children.size(); ++i) root->children[i]->parent.release();
+    TEST( root->children[2]->next->next.release() );
+  }
+
+  file.rewind();
+
+  shr<Node>   root;
+  shr<Item>   common;
+  std::string end;
+  {
+    TEST( smrt_reader r( file.fd() ) );
+    TEST( r.get(root).get(end).get(common) );
+    SHOW_STATS(r);
+  }
+
+  std::cout << "root=" << root->id << " item=" << root->item->name << " label=" << root->label->name << " end=" << end << std::endl;
+  for(std::size_t i=0; i<root->children.size(); ++i)
+  {
+    const shr<Node> &c = root->children[i];
+    std::cout << "child=" << c->id << " parent=" << ( c->parent.raw() == root.raw() )
+              << " common=" << ( c->item.raw() == common.raw() ) << " item=" << c->item->name << std::endl;
+  }
+  std::cout << "chain=" << root->children[2]->next->id
+            << " back=" << ( root->children[2]->next->next.raw() == root->children[0].raw() ) << std::endl;
+  std::cout << "refCount root=" << root.refCount() << " common=" << common.refCount()
+            << " first=" << root->children[0].refCount() << std::endl;
+
+  for(std::size_t i=0; i<root->children.size(); ++i) root->children[i]->parent.release();
+  TEST( root->children[2]->next->next.release() );
+  TEST( common.release() );
+  TEST( root.release() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+// A chain far longer than the stack could hold if it were written (or
+//   read) recursively
+
+struct Link
+{
+  long       value;
+  shr<Link>  next;
+
+  Link(void) : value(0) {}
+
+  void smrtWrite(smrt_writer &w) const { w.put(value).put(next); }
+  void smrtRead(smrt_reader &r)        { r.get(value).get(next); }
+};
+
+void unlink(shr<Link> &p)
+{
+  while( p.raw() != NULL ) { shr<Link> n = std::move(p->next); p = std::move(n); }
+}
+
+void chain_tests(void)
+{
+  std::cout << std::endl << "======> smrt_writer/smrt_reader chain tests <=======" << std::endl;
+
+  const long n = 1000000;
+  Scratch    file;
+  std::string big(1000, 'x');
+
+  {
+    shr<Link> head = make_shr<Link>();
+    shr<Link> tail = head;
+    for(long i=1; i<n; ++i) { tail->next = make_shr<Link>(); tail = tail->next; tail->value = i; }
+    tail.release();
+
+    smrt_writer w( file.fd(), 64 );
+    w.put(head).put(big);
+    w.flush();
+    SHOW_STATS(w);
+    unlink(head);
+  }
+
+  file.rewind();
+
+  shr<Link>   head;
+  std::string copy;
+  {
+    smrt_reader r( file.fd(), 64 );
+    r.get(head).get(copy);
+    SHOW_STATS(r);
+  }
+
+  long count = 0, sum = 0;
+  for(const Link *l = head.raw(); l != NULL; l = l->next.raw()) { count += 1; sum += l->value; }
+  std::cout << "count=" << count << " ok=" << ( sum == n*(n-1)/2 ) << " big=" << ( copy == big ) << std::endl;
+  unlink(head);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+// Objects of derived classes reached through pointers to their base,
+//   one of them with a second base in front of Shape
+
+struct Shape
+{
+  std::string name;
+  virtual ~Shape() { std::cout << "~Shape(" << name << ")" << std::endl; }
+  virtual std::string what(void) const { return "Shape " + name; }
+  virtual void smrtWrite(smrt_writer &w) const { w.put(name); }
+  virtual void smrtRead(smrt_reader &r)        { r.get(name); }
+};
+
+struct Circle : public Shape
+{
+  double radius;
+  Circle(void) : radius(0) {}
+  std::string what(void) const { return "Circle " + name + " r=" + std::to_string(int(radius)); }
+  void smrtWrite(smrt_writer &w) const { Shape::smrtWrite(w); w.put(radius); }
+  void smrtRead(smrt_reader &r)        { Shape::smrtRead(r); r.get(radius); }
+};
+
+struct Extra
+{
+  long extra;
+  Extra(void) : extra(42) {}
+  virtual ~Extra() {}
+  void smrtWrite(smrt_writer &w) const { w.put(extra); }
+  void smrtRead(smrt_reader &r)        { r.get(extra); }
+};
+
+struct Labelled : public Extra, public Shape
+{
+  std::string what(void) const { return "Labelled " + name + " extra=" + std::to_string(extra); }
+  void smrtWrite(smrt_writer &w) const { Shape::smrtWrite(w); w.put(extra); }
+  void smrtRead(smrt_reader &r)        { Shape::smrtRead(r); r.get(extra); }
+};
+
+struct Square : public Shape {};   // never registered
+
+void polymorphic_tests(void)
+{
+  std::cout << std::endl << "======> smrt_writer/smrt_reader polymorphic tests <=======" << std::endl;
+
+  TEST(( smrt_serial::registerType<Circle, Shape>() ));
+  TEST(( smrt_serial::registerType<Labelled, Shape>() ));
+
+  Scratch file;
+  {
+    shr<Circle> c = make_shr<Circle>();
+    c->name   = "c";
+    c->radius = 3;
+    shr<Labelled> l = make_shr<Labelled>();
+    l->name  = "l";
+    l->extra = 7;
+
+    std::vector< shr<Shape> > shapes;
+    shapes.push_back(c);
+    shapes.push_back(l);
+    shapes.push_back( make_shr<Shape>() );
+    shapes.back()->name = "s";
+    shapes.push_back(c);
+
+    own<Shape> o( new Circle );
+    o->name = "o";
+
+    smrt_writer w( file.fd() );
+    w.putVarint( shapes.size() );
+    for(std::size_t i=0; i<shapes.size(); ++i) w.put(shapes[i]);
+    TEST( w.put(c).put(l).put(o).put( std::string("tail") ) );
+    w.flush();
+    SHOW_STATS(w);
+  }
+
+  file.rewind();
+
+  std::vector< shr<Shape> > shapes;
+  shr<Circle>   c;
+  shr<Labelled> l;
+  own<Shape>    o;
+  std::string   tail;
+  {
+    smrt_reader r( file.fd() );
+    shapes.resize( r.getVarint() );
+    for(std::size_t i=0; i<shapes.size(); ++i) r.get(shapes[i]);
+    TEST( r.get(c).get(l).get(o).get(tail) );
+    SHOW_STATS(r);
+  }
+
+  for(std::size_t i=0; i<shapes.size(); ++i) std::cout << "shape=" << shapes[i]->what() << std::endl;
+  std::cout << "own=" << o->what() << " tail=" << tail << std::endl;
+  std::cout << "shared c=" << ( shapes[0].raw() == c.raw() && shapes[3].raw() == c.raw() ) << " refCount=" << c.refCount()
+            << " l=" << ( shapes[1].raw() == l.raw() ) << " refCount=" << l.refCount() << std::endl;
+
+  TEST( shapes.clear() );
+  TEST( c.release() );
+  TEST( l.release() );
+  TEST( o.release() );
+
+  // A class which was never registered cannot be written through its base
+
+  Scratch other;
+  {
+    shr<Shape> q = make_shr<Square>();
+    smrt_writer w( other.fd() );
+    try { w.put(q); std::cout << "no error" << std::endl; }
+    catch(const std::logic_error &e) { std::cout << "logic_error: " << e.what() << std::endl; }
+  }
+
+  // Nor read back through a base it was not registered with
+
+  Scratch unrelated;
+  {
+    shr<Shape> q = make_shr<Labelled>();
+    smrt_writer w( unrelated.fd() );
+    w.put(q);
+  }
+  unrelated.rewind();
+  {
+    shr<Extra> e;
+    smrt_reader r( unrelated.fd() );
+    try { r.get(e); std::cout << "no error" << std::endl; }
+    catch(const std::runtime_error &x) { std::cout << "runtime_error: " << x.what() << std::endl; }
+  }
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+#define SHOW_ERROR(x) \
+  try { x; std::cout << "no error" << std::endl; } \
+  catch(const std::exception &e) { std::cout << "error: " << e.what() << std::endl; }
+
+void error_tests(void)
+{
+  std::cout << std::endl << "======> smrt_reader error tests <=======" << std::endl;
+
+  Scratch file;
+  {
+    shr<Item> a = make_shr<Item>("a");
+    shr<Item> b = a;
+    smrt_writer w( file.fd() );
+    w.put(a).put(b);
+  }
+
+  // The same objects read as other types, or as an own<T>
+
+  file.rewind();
+  {
+    shr<Item> a;
+    shr<Node> b;
+    smrt_reader r( file.fd() );
+    SHOW_ERROR( r.get(a).get(b) );
+  }
+
+  file.rewind();
+  {
+    own<Item> a;
+    smrt_reader r( file.fd() );
+    SHOW_ERROR( r.get(a) );
+  }
+
+  // Reading past the end, and from something else entirely
+
+  file.rewind();
+  {
+    shr<Item> a, b, c;
+    smrt_reader r( file.fd() );
+    SHOW_ERROR( r.get(a).get(b).get(c) );
+    std::cout << "shared=" << ( a.raw() == b.raw() ) << " refCount=" << a.refCount() << std::endl;
+  }
+
+  Scratch other;
+  if( ::write(other.fd(), "garbage", 7) != 7 ) std::cout << "write failed" << std::endl;
+  other.rewind();
+  SHOW_ERROR( smrt_reader r( other.fd() ) );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  graph_tests();
+  chain_tests();
+  polymorphic_tests();
+  error_tests();
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+//------------------------------------------------------------
+// Built with SMARTPOINTER_STATS, so every type is tracked except those
+//   which opt out.  Threads share a Counted with atomic counting, so
+//   that its count operations are made by several threads at once.
+//------------------------------------------------------------
+
+#define SHOW_STATS(T) \
+  std::cout << std::endl << "stats> "; \
+  smrt_stats<T>::dump(std::cout);
+
+struct Untracked { int x; };
+struct Counted   { int x; };
+struct Plain     { int x; };
+
+template <> struct smrt_tracking<Untracked> { static const bool value = false; };
+template <> struct shr_counting<Counted>    { typedef shr_atomic_count Policy_t; };
+
+class Node : public ishr_counted<>
+{
+  public:
+    Node(void) { std::cout << "Creating: Node" << std::endl; }
+    ~Node()    { std::cout << "Deleting: Node" << std::endl; }
+};
+
+void stats_tests(void)
+{
+  std::cout << std::endl << "======> per type stats tests <=======" << std::endl;
+
+  TEST( own<A> o1 = new A );
+  TEST( o1 = new A );
+  TEST( shr<A> s1 = std::move(o1) );
+  TEST( shr<A> s2 = s1 );
+  TEST( const_shr<A> s3 = make_shr<A>() );
+  TEST( weak_shr<A> w = s1 );
+  TEST( shr<A> s4 = w.lock() );
+  SHOW_STATS(A);
+  TEST( s1.release() );
+  TEST( s2.release() );
+  TEST( s3.release() );
+  TEST( s4.release() );
+  SHOW_STATS(A);
+
+  TEST( shr<long[]> a1 = make_aligned_shr<long>(8) );
+  TEST( const_shr<long[]> a2 = a1 );
+  TEST( shr<long> last( a1, &a1[7] ) );
+  SHOW_STATS(long[]);
+  SHOW_STATS(long);
+
+  TEST( ishr<Node> n1 = new Node );
+  TEST( ishr<Node> n2 = n1 );
+  TEST( n1.release() );
+  TEST( n2.release() );
+  SHOW_STATS(Node);
+
+  // The same operations on a shr<T> count the same increments and decrements
+
+  TEST( shr<Plain> p1 = new Plain );
+  TEST( shr<Plain> p2 = p1 );
+  TEST( p1.release() );
+  TEST( p2.release() );
+  SHOW_STATS(Plain);
+
+  TEST( shr<Untracked> u1 = new Untracked );
+  TEST( shr<Untracked> u2 = u1 );
+  SHOW_STATS(Untracked);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void thread_tests(void)
+{
+  std::cout << std::endl << "======> threaded stats tests <=======" << std::endl;
+
+  TEST( shr<Counted> c = new Counted );
+  std::vector<std::thread> threads;
+  for(int t=0; t<4; ++t)
+  {
+    threads.push_back( std::thread( [c]{ for(int i=0; i<10000; ++i) { shr<Counted> x = c; } } ) );
+  }
+  for(std::size_t t=0; t<threads.size(); ++t) threads[t].join();
+  SHOW_STATS(Counted);
+  TEST( c.release() );
+
+  std::cout << std::endl << "all tracked types:" << std::endl;
+  smrt_stats_registry::dump(std::cout);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  stats_tests();
+  thread_tests();
+
+  return 0;
+}
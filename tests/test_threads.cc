@@ -0,0 +1,218 @@
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "SmartPointers.h"
+
+//------------------------------------------------------------
+// Passes shr<T> copies between threads under each thread safe counting
+//   policy.  Objects are created on one thread, copied on several, and
+//   released on whichever thread happens to drop the last copy.  Each
+//   test reports the number of objects still alive at the end (which
+//   should be 0) and the number of bad reads (which should also be 0).
+//   The same is done for atomic_shr<T> and epoch_own<T> cells read and
+//   written concurrently.
+//------------------------------------------------------------
+
+std::atomic<long> live(0);
+std::atomic<long> bad(0);
+
+template <int N>
+  struct Obj
+  {
+    Obj(void)  : check(12345) { ++live; }
+    ~Obj()     { check = 0; --live; }
+    long check;
+  };
+
+typedef Obj<0> AtomicObj;
+typedef Obj<1> BiasedObj;
+
+template <> struct shr_counting<AtomicObj> { typedef shr_atomic_count Policy_t; };
+template <> struct shr_counting<BiasedObj> { typedef shr_biased_count Policy_t; };
+
+template <typename T>
+  struct Mailbox
+  {
+    std::mutex              lock;
+    std::deque< shr<T> >    items;
+
+    void put(const shr<T> &p) { std::lock_guard<std::mutex> g(lock); items.push_back(p); }
+
+    shr<T> get(void)
+    {
+      std::lock_guard<std::mutex> g(lock);
+      shr<T> rval;
+      if( ! items.empty() ) { rval = items.front(); items.pop_front(); }
+      return rval;
+    }
+  };
+
+// Each worker creates objects, shares them through the mailbox, and drops
+//   (or copies and keeps for a while) whatever it receives.
+
+template <typename T>
+  void worker(Mailbox<T> &box, unsigned seed, unsigned n)
+  {
+    std::vector< shr<T> > kept;
+    std::vector< weak_shr<T> > watched;
+    for(unsigned i=0; i<n; ++i)
+    {
+      seed = seed*1103515245 + 12345;
+      shr<T> mine = make_shr<T>();
+      if( seed & 1 ) mine = shr<T>(new T);
+      box.put(mine);
+      box.put(mine);
+
+      shr<T> theirs = box.get();
+      if( theirs.isSet() && theirs->check != 12345 ) ++bad;
+      if( box.get().isNull() ) ++bad;
+      if( seed & 2 ) kept.push_back(theirs);
+      if( seed & 4 ) watched.push_back(theirs);
+      if( kept.size() > 16 ) kept.erase(kept.begin(), kept.begin()+8);
+
+      if( ! watched.empty() && (seed & 8) )
+      {
+        shr<T> w = watched.back().lock();
+        if( w.isSet() && w->check != 12345 ) ++bad;
+        watched.pop_back();
+      }
+    }
+  }
+
+// Creates objects and exits, leaving all the references to other threads
+
+template <typename T>
+  void producer(Mailbox<T> &box, unsigned n)
+  {
+    for(unsigned i=0; i<n; ++i)
+    {
+      shr<T> p = make_shr<T>();
+      shr<T> q = p;
+      box.put(p);
+      box.put(q);
+    }
+  }
+
+template <typename T>
+  void run(const char *name, unsigned nthread, unsigned n)
+  {
+    {
+      Mailbox<T> box;
+      std::vector<std::thread> workers;
+      for(unsigned t=0; t<nthread; ++t) workers.push_back( std::thread(worker<T>, std::ref(box), t+1, n) );
+      for(unsigned t=0; t<nthread; ++t) workers[t].join();
+      std::cout << name << ": threads=" << nthread << " done, mailbox holds " << box.items.size() << std::endl;
+
+      std::thread p(producer<T>, std::ref(box), n);
+      p.join();
+      std::cout << name << ": producer done, mailbox holds " << box.items.size() << std::endl;
+    }
+    shr_biased_count::collect();
+    std::cout << name << ": live objects=" << live << "  bad reads=" << bad << std::endl;
+  }
+
+//------------------------------------------------------------
+// Readers load snapshots of an atomic_shr<T> while writers store new
+//   values or replace them with compareExchange().  Every value stays
+//   alive for as long as any reader's snapshot refers to it.
+//------------------------------------------------------------
+
+template <typename T>
+  void reader(const atomic_shr<T> &cell, const std::atomic<bool> &stop)
+  {
+    while( ! stop.load() )
+    {
+      const_shr<T> snap = cell.load();
+      if( snap.isNull() || snap->check != 12345 ) ++bad;
+    }
+  }
+
+template <typename T>
+  void writer(atomic_shr<T> &cell, unsigned n)
+  {
+    for(unsigned i=0; i<n; ++i)
+    {
+      if( i & 1 ) { cell.store(make_shr<T>()); continue; }
+      const_shr<T> expected = cell.load();
+      while( ! cell.compareExchange(expected, const_shr<T>(new T)) ) {}
+    }
+  }
+
+template <typename T>
+  void run_cell(const char *name, unsigned nreader, unsigned nwriter, unsigned n)
+  {
+    {
+      atomic_shr<T> cell( make_shr<T>() );
+      std::atomic<bool> stop(false);
+      std::vector<std::thread> readers, writers;
+      for(unsigned t=0; t<nreader; ++t) readers.push_back( std::thread(reader<T>, std::cref(cell), std::cref(stop)) );
+      for(unsigned t=0; t<nwriter; ++t) writers.push_back( std::thread(writer<T>, std::ref(cell), n) );
+      for(unsigned t=0; t<nwriter; ++t) writers[t].join();
+      stop = true;
+      for(unsigned t=0; t<nreader; ++t) readers[t].join();
+    }
+    smrt_hazard::scan();
+    std::cout << name << ": readers=" << nreader << " writers=" << nwriter
+              << "  live objects=" << live << "  bad reads=" << bad << std::endl;
+  }
+
+//------------------------------------------------------------
+// Readers use const_ref<T> values loaded from an epoch_own<T> inside an
+//   smrt_epoch::Guard while writers replace them.
+//------------------------------------------------------------
+
+template <typename T>
+  void epoch_reader(const epoch_own<T> &cell, const std::atomic<bool> &stop)
+  {
+    while( ! stop.load() )
+    {
+      smrt_epoch::Guard guard;
+      const_ref<T> r = cell.load();
+      if( r.isNull() || r->check != 12345 ) ++bad;
+      std::this_thread::yield();
+      if( r->check != 12345 ) ++bad;
+    }
+  }
+
+template <typename T>
+  void epoch_writer(epoch_own<T> &cell, unsigned n)
+  {
+    for(unsigned i=0; i<n; ++i) cell.store(new T);
+  }
+
+template <typename T>
+  void run_epoch(const char *name, unsigned nreader, unsigned nwriter, unsigned n)
+  {
+    {
+      epoch_own<T> cell( new T );
+      std::atomic<bool> stop(false);
+      std::vector<std::thread> readers, writers;
+      for(unsigned t=0; t<nreader; ++t) readers.push_back( std::thread(epoch_reader<T>, std::cref(cell), std::cref(stop)) );
+      for(unsigned t=0; t<nwriter; ++t) writers.push_back( std::thread(epoch_writer<T>, std::ref(cell), n) );
+      for(unsigned t=0; t<nwriter; ++t) writers[t].join();
+      stop = true;
+      for(unsigned t=0; t<nreader; ++t) readers[t].join();
+    }
+    smrt_epoch::synchronize();
+    std::cout << name << ": readers=" << nreader << " writers=" << nwriter
+              << "  live objects=" << live << "  bad reads=" << bad << std::endl;
+  }
+
+int main(int argc,const char **argv)
+{
+  std::cout << std::endl << "======> cross thread tests <=======" << std::endl;
+  run<AtomicObj>("atomic", 4, 20000);
+  run<BiasedObj>("biased", 4, 20000);
+
+  std::cout << std::endl << "======> atomic_shr<T> tests <=======" << std::endl;
+  run_cell<AtomicObj>("atomic_shr", 4, 2, 20000);
+
+  std::cout << std::endl << "======> epoch_own<T> tests <=======" << std::endl;
+  run_epoch<AtomicObj>("epoch_own", 4, 2, 20000);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+  return 0;
+}
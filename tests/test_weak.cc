@@ -0,0 +1,95 @@
+#include <iostream>
+#include <vector>
+#include "SmartPointers.h"
+#include "test_common.h"
+
+#define SHOW_WEAK(x) \
+  std::cout << std::endl << "show> " #x << ": " \
+            << ( x.isExpired() ? "EXPIRED" : "ALIVE" ) \
+            << "  refCount=" << x.refCount() << std::endl;
+
+void const_weak_shr_tests(void)
+{
+  std::cout << std::endl << "======> const_weak_shr<T> tests <=======" << std::endl;
+  TEST( const_shr<A> a1 = new A );
+  TEST( const_weak_shr<A> w1 = a1 );
+  TEST( const_weak_shr<A> w2 = w1 );
+  TEST( const_weak_shr<A> w3 );
+  SHOW_WEAK(w1);
+  SHOW_WEAK(w3);
+
+  TEST( const_shr<A> a2 = w1.lock() );
+  SHOW_SHR(a2);
+  TEST( a2->const_func() );
+
+  TEST( a1.release() );
+  SHOW_WEAK(w2);
+  TEST( a2.release() );
+  SHOW_WEAK(w1);
+  SHOW_WEAK(w2);
+
+  TEST( a2 = w1.lock() );
+  SHOW_SHR(a2);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void weak_shr_tests(void)
+{
+  std::cout << std::endl << "======> weak_shr<T> tests <=======" << std::endl;
+  TEST( shr<A> a1 = make_shr<A>() );
+  TEST( weak_shr<A> w1 = a1 );
+  TEST( const_weak_shr<A> cw1 = w1 );
+  SHOW_WEAK(w1);
+
+  TEST( w1.lock()->func() );
+  TEST( cw1.lock()->const_func() );
+
+  TEST( shr<A> a2 = new B );
+  TEST( w1 = a2 );
+  SHOW_WEAK(w1);
+  SHOW_WEAK(cw1);
+
+  TEST( a1 = a2 );
+  SHOW_WEAK(cw1);
+  SHOW_WEAK(w1);
+
+  TEST( weak_shr<A> w2 = std::move(w1) );
+  SHOW_WEAK(w1);
+  SHOW_WEAK(w2);
+  TEST( w2.clear() );
+  SHOW_WEAK(w2);
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+void weak_cache_tests(void)
+{
+  std::cout << std::endl << "======> weak_shr<T> cache tests <=======" << std::endl;
+  TEST( std::vector< weak_shr<A> > cache );
+  TEST( shr<A> a1 = new A );
+  TEST( shr<A> a2 = make_shr<A>() );
+  TEST( cache.push_back(a1) );
+  TEST( cache.push_back(a2) );
+  TEST( a1.release() );
+  for(size_t i=0; i<cache.size(); ++i)
+  {
+    shr<A> a = cache[i].lock();
+    std::cout << "cache[" << i << "] = ";
+    if( a.isNull() ) std::cout << "EXPIRED" << std::endl;
+    else             std::cout << *a << std::endl;
+  }
+  TEST( a2.release() );
+  TEST( cache.clear() );
+
+  std::cout << std::endl << "--DONE--" << std::endl;
+}
+
+int main(int argc,const char **argv)
+{
+  const_weak_shr_tests();
+  weak_shr_tests();
+  weak_cache_tests();
+
+  return 0;
+}